@@ -0,0 +1,48 @@
+# Benchmarks of the document renderers and the MIME parser.
+# Run them with `make bench` in the repository root.
+
+QT += core gui widgets network testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+QMAKE_CXXFLAGS += -std=c++17
+
+TARGET = kristall-bench
+
+SRC = $$PWD/../src
+
+INCLUDEPATH += $$SRC $$SRC/renderers
+DEPENDPATH += $$SRC $$SRC/renderers
+
+DEFINES += KRISTALL_BENCH_CORPUS=\\\"$$PWD/corpus\\\"
+DEFINES += KRISTALL_BENCH_BASELINE=\\\"$$PWD/baseline.json\\\"
+
+external-cmark {
+    CONFIG += link_pkgconfig
+    PKGCONFIG += libcmark
+} else {
+    include($$PWD/../lib/cmark/cmark.pri)
+}
+
+SOURCES += \
+    renderbench.cpp \
+    $$SRC/documentoutlinemodel.cpp \
+    $$SRC/documentstyle.cpp \
+    $$SRC/mimeparser.cpp \
+    $$SRC/renderers/geminirenderer.cpp \
+    $$SRC/renderers/gophermaprenderer.cpp \
+    $$SRC/renderers/markdownrenderer.cpp \
+    $$SRC/renderers/plaintextrenderer.cpp \
+    $$SRC/renderers/renderhelpers.cpp \
+    $$SRC/renderers/textstyleinstance.cpp
+
+HEADERS += \
+    $$SRC/documentoutlinemodel.hpp \
+    $$SRC/documentstyle.hpp \
+    $$SRC/mimeparser.hpp \
+    $$SRC/renderers/geminirenderer.hpp \
+    $$SRC/renderers/gophermaprenderer.hpp \
+    $$SRC/renderers/markdownrenderer.hpp \
+    $$SRC/renderers/plaintextrenderer.hpp \
+    $$SRC/renderers/renderhelpers.hpp \
+    $$SRC/renderers/textstyleinstance.hpp
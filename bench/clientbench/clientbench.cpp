@@ -0,0 +1,326 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+
+#include <algorithm>
+
+#include "kristall.hpp"
+#include "protocols/geminiclient.hpp"
+#include "protocols/gopherclient.hpp"
+#include "testserver.hpp"
+
+// The protocol clients only need these globals of the application
+HostRateLimiter     kristall::rate_limits;
+SslTrust            kristall::trust::gemini;
+SslTrust            kristall::trust::https;
+
+void kristall::trust::ensureLoaded()
+{
+    // Nothing to load, the benchmark ignores TLS errors
+}
+
+bool kristall::trust::isLoaded()
+{
+    return true;
+}
+
+QString toFingerprintString(QSslCertificate const & certificate)
+{
+    return QCryptographicHash::hash(certificate.toDer(), QCryptographicHash::Sha256).toHex(':');
+}
+
+//! Requests that take longer than this are counted as failed
+static const int REQUEST_TIMEOUT = 60 * 1000; // ms
+
+//! Server settings a set of requests is measured with
+struct Scenario
+{
+    char const * name;
+    int rtt;
+    qint64 bandwidth;
+    int chunk_size;
+    int header_delay;
+};
+
+static const Scenario scenarios[] = {
+    { "loopback",     0,    0,           16384, 0 },
+    { "rtt-50ms",     50,   0,           16384, 0 },
+    { "1MBps",        0,    1000 * 1000, 16384, 0 },
+    { "64B-chunks",   0,    0,           64,    0 },
+    { "slow-header",  0,    0,           16384, 100 },
+};
+
+struct Sample
+{
+    qint64 ttfb = -1;     // ms until the header or the first body byte
+    qint64 duration = -1; // ns until the request completed
+    qint64 bytes = 0;
+    QString error;
+};
+
+//! Fetches `url` and waits until the request completed or failed.
+static Sample fetch(ProtocolHandler & client, QUrl const & url)
+{
+    Sample sample;
+    QEventLoop loop;
+    QElapsedTimer clock;
+
+    QList<QMetaObject::Connection> connections;
+    connections << QObject::connect(&client, &ProtocolHandler::requestComplete, &loop, [&](QByteArray const & data, QString const &) {
+        sample.duration = clock.nsecsElapsed();
+        sample.bytes = data.size();
+        loop.quit();
+    });
+    connections << QObject::connect(&client, &ProtocolHandler::networkError, &loop, [&](ProtocolHandler::NetworkError, QString const & reason) {
+        sample.error = reason;
+        loop.quit();
+    });
+    connections << QObject::connect(&client, &ProtocolHandler::redirected, &loop, [&](QUrl const & target, bool) {
+        sample.error = "redirected to " + target.toString();
+        loop.quit();
+    });
+    connections << QObject::connect(&client, &ProtocolHandler::inputRequired, &loop, [&](QString const &, bool) {
+        sample.error = "input required";
+        loop.quit();
+    });
+    QTimer::singleShot(REQUEST_TIMEOUT, &loop, [&]() {
+        sample.error = "timeout";
+        loop.quit();
+    });
+
+    clock.start();
+    if(client.startRequest(url, ProtocolHandler::IgnoreTlsErrors))
+        loop.exec();
+    else
+        sample.error = "request was not started";
+
+    for(auto const & connection : connections)
+        QObject::disconnect(connection);
+
+    if(client.isInProgress())
+        client.cancelRequest();
+
+    auto const & timings = client.timings();
+    sample.ttfb = timings.get(RequestTimings::HeaderReceived);
+    if(sample.ttfb < 0)
+        sample.ttfb = timings.get(RequestTimings::FirstBodyByte);
+
+    return sample;
+}
+
+//! Starts fetching `url` and returns how long cancelRequest() takes
+//! once the first bytes arrived, in ns, or -1 if that failed.
+static qint64 cancelLatency(ProtocolHandler & client, QUrl const & url)
+{
+    qint64 latency = -1;
+    QEventLoop loop;
+
+    auto connection = QObject::connect(&client, &ProtocolHandler::requestProgress, &loop, [&](qint64) {
+        if(latency >= 0)
+            return;
+        // Cancel from the event loop like the stop button does, not from within the socket
+        QTimer::singleShot(0, &loop, [&]() {
+            QElapsedTimer clock;
+            clock.start();
+            bool const cancelled = client.cancelRequest();
+            latency = clock.nsecsElapsed();
+            if(not cancelled or client.isInProgress())
+                latency = -1;
+            loop.quit();
+        });
+        latency = 0;
+    });
+    QTimer::singleShot(REQUEST_TIMEOUT, &loop, &QEventLoop::quit);
+
+    if(client.startRequest(url, ProtocolHandler::IgnoreTlsErrors))
+        loop.exec();
+
+    QObject::disconnect(connection);
+    if(client.isInProgress()) {
+        client.cancelRequest();
+        latency = -1;
+    }
+    return latency;
+}
+
+static double percentile(QVector<double> values, double p)
+{
+    if(values.isEmpty())
+        return -1;
+    std::sort(values.begin(), values.end());
+    int const index = std::min<int>(values.size() - 1, int(p * values.size()));
+    return values.at(index);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("kristall-clientbench");
+
+    QCommandLineParser cli_parser;
+    cli_parser.setApplicationDescription("Measures the throughput, time to first byte and cancel latency of the Gemini and Gopher clients.");
+    cli_parser.addHelpOption();
+
+    QCommandLineOption requests_option { "requests", "Number of requests per scenario.", "count", "10" };
+    QCommandLineOption size_option { "size", "Size of the fetched documents.", "bytes", "1048576" };
+    QCommandLineOption output_option { "output", "Writes the results as JSON to <file>.", "file", "clientbench-results.json" };
+    cli_parser.addOptions({ requests_option, size_option, output_option });
+    cli_parser.process(app);
+
+    int const request_count = std::max(1, cli_parser.value(requests_option).toInt());
+    qint64 const document_size = std::max<qint64>(1, cli_parser.value(size_option).toLongLong());
+
+    // The server runs on its own thread, so blocking calls of the clients don't stall it
+    QThread server_thread;
+    server_thread.start();
+
+    auto * server = new TestServer;
+    server->moveToThread(&server_thread);
+
+    GeminiClient gemini;
+    GopherClient gopher;
+
+    QTextStream out { stdout };
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+        .arg(QString("protocol"), -8)
+        .arg(QString("scenario"), -12)
+        .arg(QString("MB/s"), 10)
+        .arg(QString("ttfb p50"), 10)
+        .arg(QString("ttfb p90"), 10)
+        .arg(QString("cancel"), 10);
+    out.flush();
+
+    QJsonArray results;
+    bool all_ok = true;
+
+    TestServerOptions options;
+    options.root = QDir { KRISTALL_BENCH_FIXTURES };
+    options.gemini_port = 0;
+    options.gopher_port = 0;
+    options.finger_port = 0;
+
+    for(auto const & scenario : scenarios)
+    {
+        options.rtt = scenario.rtt;
+        options.bandwidth = scenario.bandwidth;
+        options.chunk_size = scenario.chunk_size;
+        options.header_delay = scenario.header_delay;
+
+        bool started = false;
+        QMetaObject::invokeMethod(server, [&]() {
+            started = server->start(options);
+        }, Qt::BlockingQueuedConnection);
+        if(not started) {
+            all_ok = false;
+            break;
+        }
+
+        // Creating the certificate is slow, it's reused for all scenarios
+        options.certificate = server->options().certificate;
+        options.private_key = server->options().private_key;
+
+        struct Target {
+            char const * protocol;
+            ProtocolHandler * client;
+            QString url;
+        };
+        Target const targets[] = {
+            { "gemini", &gemini, QString("gemini://127.0.0.1:%1/generate/%2").arg(server->port(TestServer::Gemini)) },
+            { "gopher", &gopher, QString("gopher://127.0.0.1:%1/0/generate/%2").arg(server->port(TestServer::Gopher)) },
+        };
+
+        for(auto const & target : targets)
+        {
+            QVector<double> throughputs;
+            QVector<double> ttfbs;
+            QVector<double> cancels;
+            QStringList errors;
+
+            QUrl const url { target.url.arg(document_size) };
+            for(int i = 0; i < request_count; i++)
+            {
+                Sample const sample = fetch(*target.client, url);
+                if(not sample.error.isEmpty()) {
+                    errors << sample.error;
+                    continue;
+                }
+                if(sample.bytes != document_size) {
+                    errors << QString("received %1 of %2 bytes").arg(sample.bytes).arg(document_size);
+                    continue;
+                }
+                throughputs.append(1000.0 * sample.bytes / std::max<qint64>(1, sample.duration));
+                ttfbs.append(sample.ttfb);
+            }
+
+            // Large enough to still be transferring when the first bytes arrive
+            QUrl const cancel_url { target.url.arg(16 * document_size) };
+            for(int i = 0; i < request_count; i++)
+            {
+                qint64 const latency = cancelLatency(*target.client, cancel_url);
+                if(latency < 0)
+                    errors << "cancel failed";
+                else
+                    cancels.append(latency / 1e6);
+            }
+
+            double const throughput = percentile(throughputs, 0.5);
+            double const ttfb_p50 = percentile(ttfbs, 0.5);
+            double const ttfb_p90 = percentile(ttfbs, 0.9);
+            double const cancel = percentile(cancels, 0.5);
+
+            out << QString("%1 %2 %3 %4 %5 %6\n")
+                .arg(QString(target.protocol), -8)
+                .arg(QString(scenario.name), -12)
+                .arg(throughput, 10, 'f', 2)
+                .arg(QString("%1 ms").arg(ttfb_p50), 10)
+                .arg(QString("%1 ms").arg(ttfb_p90), 10)
+                .arg(QString("%1 ms").arg(cancel, 0, 'f', 2), 10);
+            for(auto const & error : errors)
+                out << "    " << error << "\n";
+            out.flush();
+
+            all_ok = all_ok and errors.isEmpty();
+
+            results.append(QJsonObject {
+                { "protocol", target.protocol },
+                { "scenario", scenario.name },
+                { "throughput_mb_per_s", throughput },
+                { "ttfb_p50_ms", ttfb_p50 },
+                { "ttfb_p90_ms", ttfb_p90 },
+                { "cancel_p50_ms", cancel },
+                { "failures", errors.size() },
+            });
+        }
+    }
+
+    QMetaObject::invokeMethod(server, [server]() {
+        delete server;
+    }, Qt::BlockingQueuedConnection);
+    server_thread.quit();
+    server_thread.wait();
+
+    QString const results_file = cli_parser.value(output_option);
+    QFile output { results_file };
+    if(output.open(QFile::WriteOnly)) {
+        output.write(QJsonDocument(QJsonObject {
+            { "document_size", document_size },
+            { "requests", request_count },
+            { "results", results },
+        }).toJson());
+        qDebug() << "Wrote results to" << results_file;
+    } else {
+        qWarning() << "Could not write results to" << results_file << output.errorString();
+    }
+
+    return all_ok ? 0 : 1;
+}
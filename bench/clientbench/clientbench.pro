@@ -0,0 +1,38 @@
+# Benchmarks of the Gemini and Gopher clients against the loopback test servers.
+# Run them with `make bench-clients` in the repository root.
+
+QT += core gui widgets network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+QMAKE_CXXFLAGS += -std=c++17
+
+TARGET = kristall-clientbench
+
+include($$PWD/../testserver/testserver.pri)
+
+# IoUtil needs iconv on non-linux platforms
+!linux: LIBS += -liconv
+
+SOURCES += \
+    clientbench.cpp \
+    $$SRC/hostratelimiter.cpp \
+    $$SRC/ioutil.cpp \
+    $$SRC/protocolhandler.cpp \
+    $$SRC/requesttimings.cpp \
+    $$SRC/ssltrust.cpp \
+    $$SRC/trustedhost.cpp \
+    $$SRC/trustedhostcollection.cpp \
+    $$SRC/protocols/geminiclient.cpp \
+    $$SRC/protocols/gopherclient.cpp
+
+HEADERS += \
+    $$SRC/hostratelimiter.hpp \
+    $$SRC/ioutil.hpp \
+    $$SRC/protocolhandler.hpp \
+    $$SRC/requesttimings.hpp \
+    $$SRC/ssltrust.hpp \
+    $$SRC/trustedhost.hpp \
+    $$SRC/trustedhostcollection.hpp \
+    $$SRC/protocols/geminiclient.hpp \
+    $$SRC/protocols/gopherclient.hpp
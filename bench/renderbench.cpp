@@ -0,0 +1,338 @@
+#include <QtTest>
+#include <QApplication>
+#include <QFontDatabase>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextCursor>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "kristall.hpp"
+#include "geminirenderer.hpp"
+#include "gophermaprenderer.hpp"
+#include "markdownrenderer.hpp"
+#include "plaintextrenderer.hpp"
+#include "renderhelpers.hpp"
+#include "mimeparser.hpp"
+
+// The renderers only need these globals of the application
+GenericSettings     kristall::options;
+DocumentStyle       kristall::document_style(false);
+QString             kristall::default_font_family;
+QString             kristall::default_font_family_fixed;
+
+const bool kristall::EMOJIS_SUPPORTED =
+#if QT_VERSION < QT_VERSION_CHECK(5, 13, 0)
+    false;
+#else
+    true;
+#endif
+
+//! Counts the allocations done through operator new. Qt containers
+//! allocate with malloc, so these are only the C++ allocations.
+static std::atomic<quint64> allocation_count { 0 };
+
+void * operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if(void * ptr = std::malloc(size > 0 ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void * ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void * ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+//! Huge documents are created by repeating the typical one up to this size
+static const int HUGE_SIZE = 1 << 20;
+
+//! Each document is rendered at least this long to measure the time per byte
+static const qint64 MIN_DURATION = 200 * 1000 * 1000; // ns
+
+class RenderBench : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    void gemini_data();
+    void gemini();
+
+    void gophermap_data();
+    void gophermap();
+
+    void markdown_data();
+    void markdown();
+
+    void plaintext_data();
+    void plaintext();
+
+    void escapeCodes_data();
+    void escapeCodes();
+
+    void mimeParse();
+
+    void cleanupTestCase();
+
+private:
+    struct Result
+    {
+        double ns_per_byte;
+        double allocations;
+    };
+
+    //! Adds the small, typical and huge document of the corpus with the given extension.
+    void addCorpus(QString const & extension);
+
+    //! Measures `render` over `bytes` bytes and stores the result under the current test name.
+    template<typename F>
+    void measure(qint64 bytes, F && render);
+
+private:
+    QMap<QString, Result> results;
+    QUrl root_url { "gemini://example.org/log/index.gmi" };
+};
+
+void RenderBench::initTestCase()
+{
+    kristall::default_font_family = QFontDatabase::systemFont(QFontDatabase::GeneralFont).family();
+    kristall::default_font_family_fixed = QFontInfo(QFont("monospace")).family();
+    kristall::document_style.initialiseDefaultFonts();
+}
+
+void RenderBench::addCorpus(const QString &extension)
+{
+    QTest::addColumn<QByteArray>("document");
+
+    QByteArray typical;
+    for(QString size : { "small", "typical" })
+    {
+        QFile file { QString(KRISTALL_BENCH_CORPUS "/%1.%2").arg(size, extension) };
+        QVERIFY2(file.open(QFile::ReadOnly), qPrintable(file.fileName()));
+        QByteArray data = file.readAll();
+        QTest::newRow(qPrintable(size)) << data;
+        typical = data;
+    }
+
+    // Gophermaps end with a single dot, which would stop the renderer
+    if(typical.endsWith(".\r\n"))
+        typical.chop(3);
+
+    QByteArray huge;
+    huge.reserve(HUGE_SIZE + typical.size());
+    while(huge.size() < HUGE_SIZE)
+        huge.append(typical);
+    QTest::newRow("huge") << huge;
+}
+
+template<typename F>
+void RenderBench::measure(qint64 bytes, F && render)
+{
+    // Warm up caches and lazily initialised statics
+    render();
+
+    quint64 const allocations_before = allocation_count.load(std::memory_order_relaxed);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    int iterations = 0;
+    do {
+        render();
+        iterations += 1;
+    } while(timer.nsecsElapsed() < MIN_DURATION);
+
+    qint64 const elapsed = timer.nsecsElapsed();
+    quint64 const allocations = allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+    Result result;
+    result.ns_per_byte = double(elapsed) / iterations / std::max<qint64>(1, bytes);
+    result.allocations = double(allocations) / iterations;
+
+    QString name = QTest::currentTestFunction();
+    if(QTest::currentDataTag() != nullptr)
+        name += QString("/") + QTest::currentDataTag();
+    this->results.insert(name, result);
+
+    qDebug().noquote() << QString("%1: %2 ns/byte, %3 allocations per run")
+        .arg(name)
+        .arg(result.ns_per_byte, 0, 'f', 2)
+        .arg(result.allocations, 0, 'f', 0);
+
+    QBENCHMARK {
+        render();
+    }
+}
+
+void RenderBench::gemini_data()
+{
+    this->addCorpus("gmi");
+}
+
+void RenderBench::gemini()
+{
+    QFETCH(QByteArray, document);
+    this->measure(document.size(), [&]() {
+        DocumentOutlineModel outline;
+        QString title;
+        auto result = GeminiRenderer::render(document, this->root_url, kristall::document_style, outline, &title);
+        Q_UNUSED(result)
+    });
+}
+
+void RenderBench::gophermap_data()
+{
+    this->addCorpus("gophermap");
+}
+
+void RenderBench::gophermap()
+{
+    QFETCH(QByteArray, document);
+    QUrl const url { "gopher://example.org/1/" };
+    this->measure(document.size(), [&]() {
+        auto result = GophermapRenderer::render(document, url, kristall::document_style);
+        Q_UNUSED(result)
+    });
+}
+
+void RenderBench::markdown_data()
+{
+    this->addCorpus("md");
+}
+
+void RenderBench::markdown()
+{
+    QFETCH(QByteArray, document);
+    this->measure(document.size(), [&]() {
+        DocumentOutlineModel outline;
+        QString title;
+        auto result = MarkdownRenderer::render(document, this->root_url, kristall::document_style, outline, title);
+        Q_UNUSED(result)
+    });
+}
+
+void RenderBench::plaintext_data()
+{
+    this->addCorpus("txt");
+}
+
+void RenderBench::plaintext()
+{
+    QFETCH(QByteArray, document);
+    this->measure(document.size(), [&]() {
+        auto result = PlainTextRenderer::render(document, kristall::document_style);
+        Q_UNUSED(result)
+    });
+}
+
+void RenderBench::escapeCodes_data()
+{
+    this->addCorpus("txt");
+}
+
+void RenderBench::escapeCodes()
+{
+    QFETCH(QByteArray, document);
+    QTextCharFormat format;
+    this->measure(document.size(), [&]() {
+        QTextDocument text_document;
+        QTextCursor cursor { &text_document };
+        renderhelpers::renderEscapeCodes(document, format, cursor);
+    });
+}
+
+void RenderBench::mimeParse()
+{
+    QFile file { KRISTALL_BENCH_CORPUS "/mime-types.txt" };
+    QVERIFY(file.open(QFile::ReadOnly));
+
+    QStringList mime_types;
+    qint64 bytes = 0;
+    for(auto const & line : file.readAll().split('\n'))
+    {
+        if(line.isEmpty())
+            continue;
+        mime_types.append(QString::fromUtf8(line));
+        bytes += line.size();
+    }
+
+    this->measure(bytes, [&]() {
+        for(auto const & mime : mime_types) {
+            auto result = MimeParser::parse(mime);
+            Q_UNUSED(result)
+        }
+    });
+}
+
+void RenderBench::cleanupTestCase()
+{
+    QJsonObject current;
+    for(auto it = this->results.begin(); it != this->results.end(); ++it)
+    {
+        current.insert(it.key(), QJsonObject {
+            { "ns_per_byte", it->ns_per_byte },
+            { "allocations", it->allocations },
+        });
+    }
+
+    QString results_file = qEnvironmentVariable("KRISTALL_BENCH_RESULTS", "bench-results.json");
+    QFile output { results_file };
+    if(output.open(QFile::WriteOnly)) {
+        output.write(QJsonDocument(current).toJson());
+        qDebug() << "Wrote results to" << results_file;
+    } else {
+        qWarning() << "Could not write results to" << results_file << output.errorString();
+    }
+
+    QFile baseline_file { qEnvironmentVariable("KRISTALL_BENCH_BASELINE", KRISTALL_BENCH_BASELINE) };
+    if(not baseline_file.open(QFile::ReadOnly)) {
+        qDebug() << "No baseline to compare with";
+        return;
+    }
+    QJsonObject const baseline = QJsonDocument::fromJson(baseline_file.readAll()).object();
+
+    // Timings vary between runs, allocations only change with the code
+    bool ok = false;
+    double time_tolerance = qEnvironmentVariable("KRISTALL_BENCH_TOLERANCE").toDouble(&ok);
+    if(not ok)
+        time_tolerance = 0.25;
+
+    QStringList regressions;
+    for(auto it = this->results.begin(); it != this->results.end(); ++it)
+    {
+        if(not baseline.contains(it.key())) {
+            qDebug().noquote() << it.key() << "has no baseline";
+            continue;
+        }
+        QJsonObject const reference = baseline.value(it.key()).toObject();
+
+        double const base_time = reference.value("ns_per_byte").toDouble();
+        double const base_allocations = reference.value("allocations").toDouble();
+
+        if(base_time > 0 and it->ns_per_byte > base_time * (1.0 + time_tolerance)) {
+            regressions << QString("%1: %2 ns/byte, baseline %3 ns/byte")
+                .arg(it.key()).arg(it->ns_per_byte, 0, 'f', 2).arg(base_time, 0, 'f', 2);
+        }
+        if(it->allocations > base_allocations * 1.01 + 1.0) {
+            regressions << QString("%1: %2 allocations, baseline %3")
+                .arg(it.key()).arg(it->allocations, 0, 'f', 0).arg(base_allocations, 0, 'f', 0);
+        }
+    }
+
+    if(not regressions.isEmpty()) {
+        QFAIL(qPrintable("Regressions against the baseline:\n" + regressions.join("\n")));
+    }
+}
+
+QTEST_MAIN(RenderBench)
+
+#include "renderbench.moc"
@@ -0,0 +1,79 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDebug>
+
+#include "testserver.hpp"
+
+static QByteArray readFile(QString const & file_name)
+{
+    QFile file { file_name };
+    if(not file.open(QFile::ReadOnly)) {
+        qWarning() << "failed to read" << file_name << file.errorString();
+        return QByteArray { };
+    }
+    return file.readAll();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("kristall-testserver");
+
+    QCommandLineParser cli_parser;
+    cli_parser.setApplicationDescription("Loopback Gemini, Gopher and Finger servers for testing Kristall.");
+    cli_parser.addHelpOption();
+
+    QCommandLineOption root_option { "root", "Serves the files of <dir>.", "dir", KRISTALL_BENCH_FIXTURES };
+    QCommandLineOption gemini_option { "gemini-port", "Port of the Gemini server.", "port", "19650" };
+    QCommandLineOption gopher_option { "gopher-port", "Port of the Gopher server.", "port", "17070" };
+    QCommandLineOption finger_option { "finger-port", "Port of the Finger server.", "port", "17979" };
+    QCommandLineOption rtt_option { "rtt", "Delays every response by <ms>.", "ms", "0" };
+    QCommandLineOption bandwidth_option { "bandwidth", "Limits each connection to <bytes> per second.", "bytes", "0" };
+    QCommandLineOption chunk_option { "chunk-size", "Writes responses in chunks of <bytes>.", "bytes", "16384" };
+    QCommandLineOption header_option { "header-delay", "Waits <ms> between the Gemini header and the body.", "ms", "0" };
+    QCommandLineOption status_option { "status", "Answers every Gemini request with <code>.", "code", "0" };
+    QCommandLineOption rate_option { "rate-limit", "Answers with 44 after <count> Gemini requests per second.", "count", "0" };
+    QCommandLineOption cert_option { "cert", "PEM certificate of the Gemini server, a self-signed one is created otherwise.", "file" };
+    QCommandLineOption key_option { "key", "PEM private key of the Gemini server.", "file" };
+
+    cli_parser.addOptions({
+        root_option, gemini_option, gopher_option, finger_option,
+        rtt_option, bandwidth_option, chunk_option, header_option,
+        status_option, rate_option, cert_option, key_option,
+    });
+    cli_parser.process(app);
+
+    TestServerOptions options;
+    options.root = QDir { cli_parser.value(root_option) };
+    options.gemini_port = cli_parser.value(gemini_option).toUShort();
+    options.gopher_port = cli_parser.value(gopher_option).toUShort();
+    options.finger_port = cli_parser.value(finger_option).toUShort();
+    options.rtt = cli_parser.value(rtt_option).toInt();
+    options.bandwidth = cli_parser.value(bandwidth_option).toLongLong();
+    options.chunk_size = cli_parser.value(chunk_option).toInt();
+    options.header_delay = cli_parser.value(header_option).toInt();
+    options.status = cli_parser.value(status_option).toInt();
+    options.rate_limit = cli_parser.value(rate_option).toInt();
+
+    if(cli_parser.isSet(cert_option) or cli_parser.isSet(key_option)) {
+        options.certificate = QSslCertificate { readFile(cli_parser.value(cert_option)), QSsl::Pem };
+        options.private_key = QSslKey { readFile(cli_parser.value(key_option)), QSsl::Rsa, QSsl::Pem };
+        if(options.certificate.isNull() or options.private_key.isNull()) {
+            qWarning() << "invalid certificate or key";
+            return 1;
+        }
+    }
+
+    TestServer server;
+    if(not server.start(options))
+        return 1;
+
+    qDebug().noquote() << QString("serving %1 on gemini://127.0.0.1:%2/ gopher://127.0.0.1:%3/ finger://127.0.0.1:%4/")
+        .arg(options.root.absolutePath())
+        .arg(server.port(TestServer::Gemini))
+        .arg(server.port(TestServer::Gopher))
+        .arg(server.port(TestServer::Finger));
+
+    return app.exec();
+}
@@ -0,0 +1,417 @@
+#include "testserver.hpp"
+#include "certificatehelper.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QSslSocket>
+#include <QTimer>
+#include <QUrl>
+#include <QDebug>
+
+#include <algorithm>
+
+//! Requests are a single line, longer ones are rejected
+static const int MAX_REQUEST_SIZE = 2048;
+
+//! Unlimited transfers stop writing when this many bytes are buffered in the socket
+static const qint64 MAX_BUFFERED = 256 * 1024;
+
+//! Sends a response over a socket, shaped by the options of the server.
+//! Lives as a child of the socket, so it dies with the connection.
+class Transfer : public QObject
+{
+public:
+    Transfer(QTcpSocket * socket, TestServerOptions const & options, QByteArray const & header, QByteArray const & body) :
+        QObject(socket),
+        socket(socket),
+        options(options),
+        header(header),
+        body(body)
+    {
+        connect(socket, &QTcpSocket::bytesWritten, this, [this]() {
+            if(this->waiting_for_socket) {
+                this->waiting_for_socket = false;
+                this->pump();
+            }
+        });
+    }
+
+    void begin()
+    {
+        QTimer::singleShot(this->options.rtt, Qt::PreciseTimer, this, [this]() {
+            if(this->header.isEmpty()) {
+                this->beginBody();
+                return;
+            }
+            this->socket->write(this->header);
+            this->socket->flush();
+            QTimer::singleShot(this->options.header_delay, Qt::PreciseTimer, this, &Transfer::beginBody);
+        });
+    }
+
+private:
+    void beginBody()
+    {
+        this->clock.start();
+        this->pump();
+    }
+
+    void pump()
+    {
+        int const chunk_size = std::max(1, this->options.chunk_size);
+        while(this->offset < this->body.size())
+        {
+            if(this->options.bandwidth > 0) {
+                // Each chunk is sent once the bytes before it fit into the bandwidth
+                qint64 const due = 1000 * this->offset / this->options.bandwidth;
+                qint64 const now = this->clock.elapsed();
+                if(now < due) {
+                    QTimer::singleShot(int(due - now), Qt::PreciseTimer, this, &Transfer::pump);
+                    return;
+                }
+            }
+            if(this->socket->bytesToWrite() >= std::max<qint64>(chunk_size, MAX_BUFFERED)) {
+                this->waiting_for_socket = true;
+                return;
+            }
+
+            int const length = std::min<qint64>(chunk_size, this->body.size() - this->offset);
+            qint64 const written = this->socket->write(this->body.constData() + this->offset, length);
+            if(written < 0) {
+                this->socket->abort();
+                return;
+            }
+            this->offset += written;
+
+            // Small chunks should arrive as separate segments
+            this->socket->flush();
+        }
+
+        this->socket->disconnectFromHost();
+    }
+
+private:
+    QTcpSocket * socket;
+    TestServerOptions const & options;
+    QByteArray header;
+    QByteArray body;
+    qint64 offset = 0;
+    QElapsedTimer clock;
+    bool waiting_for_socket = false;
+};
+
+void TestServer::Listener::incomingConnection(qintptr handle)
+{
+    this->on_connection(handle);
+}
+
+TestServer::TestServer(QObject *parent) : QObject(parent)
+{
+
+}
+
+TestServer::~TestServer()
+{
+    this->stop();
+}
+
+bool TestServer::start(const TestServerOptions &options)
+{
+    this->stop();
+    this->server_options = options;
+
+    if(this->server_options.certificate.isNull() or this->server_options.private_key.isNull())
+    {
+        auto identity = CertificateHelper::createNewIdentity("localhost", QDateTime::currentDateTime().addDays(1));
+        if(not identity.isValid()) {
+            qWarning() << "failed to create a certificate for the gemini server";
+            return false;
+        }
+        this->server_options.certificate = identity.certificate();
+        this->server_options.private_key = identity.privateKey();
+    }
+
+    quint16 const ports[3] = {
+        this->server_options.gemini_port,
+        this->server_options.gopher_port,
+        this->server_options.finger_port,
+    };
+
+    for(int i = 0; i < 3; i++)
+    {
+        auto const protocol = Protocol(i);
+        auto * listener = new Listener;
+        listener->setParent(this);
+        listener->on_connection = [this, protocol](qintptr handle) {
+            QTcpSocket * socket = (protocol == Gemini) ? new QSslSocket(this) : new QTcpSocket(this);
+            if(not socket->setSocketDescriptor(handle)) {
+                delete socket;
+                return;
+            }
+            this->acceptConnection(socket, protocol);
+        };
+        this->listeners[i] = listener;
+
+        if(not listener->listen(QHostAddress::LocalHost, ports[i])) {
+            qWarning() << "failed to listen on port" << ports[i] << listener->errorString();
+            this->stop();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void TestServer::stop()
+{
+    for(auto & listener : this->listeners)
+    {
+        delete listener;
+        listener = nullptr;
+    }
+    for(auto * socket : this->findChildren<QTcpSocket*>(QString { }, Qt::FindDirectChildrenOnly))
+    {
+        socket->abort();
+        socket->deleteLater();
+    }
+    this->recent_requests.clear();
+}
+
+quint16 TestServer::port(Protocol protocol) const
+{
+    if(this->listeners[protocol] == nullptr)
+        return 0;
+    return this->listeners[protocol]->serverPort();
+}
+
+void TestServer::acceptConnection(QTcpSocket *socket, Protocol protocol)
+{
+    connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+    auto * request = new QByteArray;
+    connect(socket, &QObject::destroyed, [request]() { delete request; });
+
+    connect(socket, &QTcpSocket::readyRead, this, [this, socket, protocol, request]() {
+        if(request->endsWith('\n'))
+            return; // already answered
+        request->append(socket->readAll());
+
+        int const end = request->indexOf('\n');
+        if(end < 0) {
+            if(request->size() > MAX_REQUEST_SIZE)
+                socket->abort();
+            return;
+        }
+        request->truncate(end + 1);
+
+        QByteArray line = request->left(end);
+        if(line.endsWith('\r'))
+            line.chop(1);
+
+        auto response = this->respond(protocol, line);
+        auto * transfer = new Transfer(socket, this->server_options, response.header, response.body);
+        transfer->begin();
+    });
+
+    if(protocol == Gemini)
+    {
+        auto * ssl_socket = static_cast<QSslSocket*>(socket);
+        ssl_socket->setProtocol(QSsl::TlsV1_2OrLater);
+        ssl_socket->setLocalCertificate(this->server_options.certificate);
+        ssl_socket->setPrivateKey(this->server_options.private_key);
+        ssl_socket->setPeerVerifyMode(QSslSocket::QueryPeer);
+        ssl_socket->startServerEncryption();
+    }
+}
+
+TestServer::Response TestServer::respond(Protocol protocol, const QByteArray &request)
+{
+    switch(protocol)
+    {
+    case Gemini: return this->respondGemini(request);
+    case Gopher: return this->respondGopher(request);
+    case Finger: return this->respondFinger(request);
+    }
+    return Response { };
+}
+
+TestServer::Response TestServer::respondGemini(const QByteArray &request)
+{
+    Response response;
+
+    QUrl const url { QString::fromUtf8(request), QUrl::StrictMode };
+    if(not url.isValid() or url.scheme() != "gemini") {
+        response.header = "59 Bad request\r\n";
+        return response;
+    }
+
+    if(not this->takeRateToken()) {
+        response.header = "44 1\r\n";
+        return response;
+    }
+
+    int const status = this->server_options.status;
+    if(status != 0 and status / 10 != 2)
+    {
+        QByteArray meta;
+        switch(status / 10)
+        {
+        case 1: meta = "Input required"; break;
+        case 3: meta = url.resolved(QUrl("/")).toEncoded(); break;
+        case 4: meta = (status == 44) ? "1" : "Injected temporary failure"; break;
+        case 6: meta = "Certificate required"; break;
+        default: meta = "Injected failure"; break;
+        }
+        response.header = QByteArray::number(status) + " " + meta + "\r\n";
+        return response;
+    }
+
+    if(url.path().startsWith("/generate/")) {
+        response.header = "20 text/gemini\r\n";
+        response.body = generate(url.path().mid(10).toLongLong());
+        return response;
+    }
+
+    QString file_name = this->resolve(url.path());
+    if(not file_name.isEmpty() and QFileInfo(file_name).isDir())
+        file_name = this->resolve(url.path() + "/index.gmi");
+
+    QFile file { file_name };
+    if(file_name.isEmpty() or not file.open(QFile::ReadOnly)) {
+        response.header = "51 Not found\r\n";
+        return response;
+    }
+
+    QString mime;
+    if(file_name.endsWith(".gmi") or file_name.endsWith(".gemini"))
+        mime = "text/gemini";
+    else
+        mime = QMimeDatabase().mimeTypeForFile(file_name).name();
+
+    response.header = "20 " + mime.toUtf8() + "\r\n";
+    response.body = file.readAll();
+    return response;
+}
+
+TestServer::Response TestServer::respondGopher(const QByteArray &request)
+{
+    Response response;
+
+    // Queries of search servers are separated with a tab
+    QString const selector = QString::fromUtf8(request.split('\t').first());
+
+    if(selector.startsWith("/generate/")) {
+        response.body = generate(selector.mid(10).toLongLong());
+        return response;
+    }
+
+    QString const file_name = this->resolve(selector);
+    if(file_name.isEmpty()) {
+        response.body = "3Not found\t\terror.host\t1\r\n.\r\n";
+        return response;
+    }
+
+    QFileInfo const info { file_name };
+    if(info.isFile()) {
+        QFile file { file_name };
+        if(file.open(QFile::ReadOnly))
+            response.body = file.readAll();
+        return response;
+    }
+
+    QFile gophermap { QDir(file_name).filePath("gophermap") };
+    if(gophermap.open(QFile::ReadOnly)) {
+        response.body = gophermap.readAll();
+        return response;
+    }
+
+    // Directories without a gophermap are listed
+    QString const base = selector.endsWith('/') ? selector : selector + "/";
+    for(auto const & entry : QDir(file_name).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot, QDir::Name))
+    {
+        response.body.append(entry.isDir() ? '1' : '0');
+        response.body.append(QString("%1\t%2%1\t127.0.0.1\t%3\r\n")
+            .arg(entry.fileName(), base)
+            .arg(this->port(Gopher))
+            .toUtf8());
+    }
+    response.body.append(".\r\n");
+    return response;
+}
+
+TestServer::Response TestServer::respondFinger(const QByteArray &request)
+{
+    Response response;
+
+    QByteArray user = request.trimmed();
+    if(user.startsWith("/W"))
+        user = user.mid(2).trimmed();
+
+    if(user.startsWith("/generate/")) {
+        response.body = generate(user.mid(10).toLongLong());
+        return response;
+    }
+
+    if(user.isEmpty()) {
+        QDir const users { this->resolve("/finger") };
+        for(auto const & entry : users.entryInfoList(QStringList { "*.txt" }, QDir::Files, QDir::Name))
+            response.body.append(entry.completeBaseName().toUtf8() + "\r\n");
+        return response;
+    }
+
+    QFile file { this->resolve("/finger/" + QString::fromUtf8(user) + ".txt") };
+    if(file.fileName().isEmpty() or not file.open(QFile::ReadOnly)) {
+        response.body = "No such user.\r\n";
+        return response;
+    }
+    response.body = file.readAll();
+    return response;
+}
+
+QString TestServer::resolve(const QString &path) const
+{
+    QString const root = this->server_options.root.canonicalPath();
+    if(root.isEmpty())
+        return QString { };
+
+    QString const file_name = QFileInfo(root + "/" + path).canonicalFilePath();
+    if(file_name.isEmpty())
+        return QString { };
+    if(file_name != root and not file_name.startsWith(root + "/"))
+        return QString { };
+    return file_name;
+}
+
+bool TestServer::takeRateToken()
+{
+    if(this->server_options.rate_limit <= 0)
+        return true;
+
+    qint64 const now = QDateTime::currentMSecsSinceEpoch();
+    while(not this->recent_requests.isEmpty() and this->recent_requests.first() <= now - 1000)
+        this->recent_requests.removeFirst();
+
+    if(this->recent_requests.size() >= this->server_options.rate_limit)
+        return false;
+    this->recent_requests.append(now);
+    return true;
+}
+
+QByteArray TestServer::generate(qint64 size)
+{
+    size = std::max<qint64>(0, size);
+
+    QByteArray data;
+    data.reserve(size);
+    for(int line = 1; data.size() < size; line++)
+    {
+        data.append(QString("Line %1: The quick brown fox jumps over the lazy dog.\n")
+            .arg(line, 6, 10, QChar('0'))
+            .toUtf8());
+    }
+    data.truncate(size);
+    return data;
+}
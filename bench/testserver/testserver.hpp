@@ -0,0 +1,120 @@
+#ifndef TESTSERVER_HPP
+#define TESTSERVER_HPP
+
+#include <QObject>
+#include <QDir>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QTcpServer>
+#include <QVector>
+
+#include <functional>
+
+class QTcpSocket;
+
+//! Knobs of the test servers. All delays are in milliseconds,
+//! a value of zero disables the knob.
+struct TestServerOptions
+{
+    //! Directory the servers serve their files from
+    QDir root;
+
+    //! Ports to listen on, zero picks a free port
+    quint16 gemini_port = 19650;
+    quint16 gopher_port = 17070;
+    quint16 finger_port = 17979;
+
+    //! Delay before the first response byte, simulating the round trip time
+    int rtt = 0;
+
+    //! Maximum bytes per second sent on each connection
+    qint64 bandwidth = 0;
+
+    //! Number of bytes written to the socket at once
+    int chunk_size = 16384;
+
+    //! Additional delay between the response header and the body
+    int header_delay = 0;
+
+    //! Gemini status code sent for every request instead of the file
+    int status = 0;
+
+    //! Gemini requests per second that are served before answering with `44`
+    int rate_limit = 0;
+
+    //! PEM encoded certificate and key of the Gemini server.
+    //! When empty, a self-signed certificate is created.
+    QSslCertificate certificate;
+    QSslKey private_key;
+};
+
+//! Loopback Gemini, Gopher and Finger servers for testing and benchmarking the clients.
+//! Besides the files of the root directory, every server serves
+//! `/generate/<bytes>`, a generated text document of the given size.
+class TestServer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Protocol {
+        Gemini,
+        Gopher,
+        Finger,
+    };
+
+    explicit TestServer(QObject * parent = nullptr);
+    ~TestServer() override;
+
+    //! Starts listening on 127.0.0.1 with the given options.
+    //! Must be called on the thread the server lives on.
+    Q_INVOKABLE bool start(TestServerOptions const & options);
+
+    //! Stops listening and drops all open connections.
+    Q_INVOKABLE void stop();
+
+    //! Returns the port the server for `protocol` listens on.
+    quint16 port(Protocol protocol) const;
+
+    TestServerOptions const & options() const {
+        return this->server_options;
+    }
+
+private:
+    struct Response
+    {
+        QByteArray header;
+        QByteArray body;
+    };
+
+    void acceptConnection(QTcpSocket * socket, Protocol protocol);
+
+    Response respond(Protocol protocol, QByteArray const & request);
+
+    Response respondGemini(QByteArray const & request);
+    Response respondGopher(QByteArray const & request);
+    Response respondFinger(QByteArray const & request);
+
+    //! Resolves `path` below the root directory, returns an empty string
+    //! if it doesn't exist or is outside of the root.
+    QString resolve(QString const & path) const;
+
+    //! Returns true if another Gemini request can be served this second
+    bool takeRateToken();
+
+    static QByteArray generate(qint64 size);
+
+private:
+    //! Hands incoming connections to a callback, so TLS can be started before Qt sees the socket
+    class Listener : public QTcpServer
+    {
+    public:
+        std::function<void(qintptr)> on_connection;
+    protected:
+        void incomingConnection(qintptr handle) override;
+    };
+
+    TestServerOptions server_options;
+    Listener * listeners[3] = { };
+    QVector<qint64> recent_requests; // ms since epoch
+};
+
+#endif // TESTSERVER_HPP
@@ -0,0 +1,23 @@
+# The test servers, shared by the server tool and the client benchmark.
+
+QT += network
+
+SRC = $$PWD/../../src
+
+INCLUDEPATH += $$PWD $$SRC
+DEPENDPATH += $$PWD $$SRC
+
+DEFINES += KRISTALL_BENCH_FIXTURES=\\\"$$PWD/../fixtures\\\"
+
+# The self-signed certificate is created with OpenSSL
+!win32: LIBS += -lcrypto
+
+SOURCES += \
+    $$PWD/testserver.cpp \
+    $$SRC/certificatehelper.cpp \
+    $$SRC/cryptoidentity.cpp
+
+HEADERS += \
+    $$PWD/testserver.hpp \
+    $$SRC/certificatehelper.hpp \
+    $$SRC/cryptoidentity.hpp
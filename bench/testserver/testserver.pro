@@ -0,0 +1,16 @@
+# Loopback Gemini, Gopher and Finger servers serving bench/fixtures.
+# Build and start them with `make testserver` in the repository root.
+
+QT += core network
+QT -= gui
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+QMAKE_CXXFLAGS += -std=c++17
+
+TARGET = kristall-testserver
+
+include($$PWD/testserver.pri)
+
+SOURCES += \
+    main.cpp
@@ -2,10 +2,7 @@
 #include "ui_browsertab.h"
 #include "mainwindow.hpp"
 
-#include "renderers/gophermaprenderer.hpp"
 #include "renderers/geminirenderer.hpp"
-#include "renderers/plaintextrenderer.hpp"
-#include "renderers/markdownrenderer.hpp"
 #include "renderers/renderhelpers.hpp"
 
 #include "mimeparser.hpp"
@@ -19,6 +16,7 @@
 #include "protocols/fingerclient.hpp"
 #include "protocols/abouthandler.hpp"
 #include "protocols/filehandler.hpp"
+#include "protocols/archivehandler.hpp"
 
 #include "ioutil.hpp"
 #include "kristall.hpp"
@@ -52,7 +50,6 @@
 #include <QGraphicsPixmapItem>
 #include <QGraphicsTextItem>
 #include <QRegularExpression>
-#include <iconv.h>
 
 BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
                                                  ui(new Ui::BrowserTab),
@@ -65,6 +62,10 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
 
     this->setUiDensity(kristall::options.ui_density);
 
+    // Replayed responses take precedence over all network protocols
+    if(kristall::archive.isReplaying())
+        addProtocolHandler<ArchiveHandler>();
+
     addProtocolHandler<GeminiClient>();
     addProtocolHandler<FingerClient>();
     addProtocolHandler<GopherClient>();
@@ -102,6 +103,21 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
 
     connect(&this->network_timeout_timer, &QTimer::timeout, this, &BrowserTab::on_networkTimeout);
 
+    this->throttle_timer.setSingleShot(true);
+    connect(&this->throttle_timer, &QTimer::timeout, this, &BrowserTab::on_throttleTimeout);
+
+    this->outline_timer.setSingleShot(true);
+    this->outline_timer.setInterval(16);
+    connect(&this->outline_timer, &QTimer::timeout, this, &BrowserTab::on_outlineTimeout);
+    connect(this->ui->text_browser->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        if(not this->outline_timer.isActive())
+            this->outline_timer.start();
+    });
+
+    this->last_active.start();
+
+    connect(&kristall::coalescer, &RequestCoalescer::completed, this, &BrowserTab::on_coalescedRequestCompleted);
+    connect(&kristall::coalescer, &RequestCoalescer::abandoned, this, &BrowserTab::on_coalescedRequestAbandoned);
 
 
     {
@@ -115,6 +131,8 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
     {
         connect(this->ui->search_box, &SearchBox::searchNext, this, &BrowserTab::on_search_next_clicked);
         connect(this->ui->search_box, &SearchBox::searchPrev, this, &BrowserTab::on_search_previous_clicked);
+        connect(&this->page_search, &PageSearch::matchesFound, this, &BrowserTab::on_pageSearchMatches);
+        connect(&this->page_search, &PageSearch::finished, this, &BrowserTab::on_pageSearchFinished);
     }
     {
         QShortcut * sc = new QShortcut(QKeySequence("Escape"), this->ui->search_bar);
@@ -167,11 +185,16 @@ BrowserTab::BrowserTab(MainWindow *mainWindow) : QWidget(nullptr),
 
 BrowserTab::~BrowserTab()
 {
+    this->releaseCoalescedRequest();
+    kristall::memory.release(this);
     delete ui;
 }
 
-void BrowserTab::navigateTo(const QUrl &url, PushToHistory mode, RequestFlags flags)
+void BrowserTab::navigateTo(const QUrl &requested_url, PushToHistory mode, RequestFlags flags)
 {
+    // Go directly to documents that were permanently moved
+    QUrl const url = kristall::redirects.resolve(requested_url);
+
     if (kristall::protocols.isSchemeSupported(url.scheme()) != ProtocolSetup::Enabled)
     {
         QMessageBox::warning(this, "Kristall", "URI scheme not supported or disabled: " + url.scheme());
@@ -184,13 +207,15 @@ void BrowserTab::navigateTo(const QUrl &url, PushToHistory mode, RequestFlags fl
         return;
     }
 
-    // If this page is in cache, store the scroll position
-    if (auto pg = kristall::cache.find(this->current_location); pg != nullptr)
+    // If this page is in cache, store the scroll position. A tab that has a
+    // pending scroll position doesn't display its page yet.
+    if (auto pg = kristall::cache.find(this->current_location); pg != nullptr and this->pending_scroll_pos < 0)
     {
         pg->scroll_pos = this->ui->text_browser->verticalScrollBar()->value();
     }
 
     this->redirection_count = 0;
+    this->slow_down_count = 0;
     this->successfully_loaded = false;
     this->timer.start();
 
@@ -393,6 +418,21 @@ void BrowserTab::on_parent_button_clicked()
 void BrowserTab::on_networkError(ProtocolHandler::NetworkError error_code, const QString &reason)
 {
     this->network_timeout_timer.stop();
+    this->releaseCoalescedRequest();
+
+    // Hold the request back until the server accepts requests again,
+    // but give up when the server keeps telling us to slow down.
+    if(error_code == ProtocolHandler::SlowDown)
+    {
+        const int max_slow_down_retries = 5;
+
+        this->slow_down_count += 1;
+        if((this->slow_down_count <= max_slow_down_retries) and kristall::rate_limits.isThrottled(this->current_location.host()))
+        {
+            this->holdRequest(this->current_location, this->current_options);
+            return;
+        }
+    }
 
     QString file_name;
     switch(error_code)
@@ -411,6 +451,7 @@ void BrowserTab::on_networkError(ProtocolHandler::NetworkError error_code, const
     case ProtocolHandler::Unauthorized: file_name = "Unauthorized.gemini"; break;
     case ProtocolHandler::TlsFailure: file_name = "TlsFailure.gemini"; break;
     case ProtocolHandler::Timeout: file_name = "Timeout.gemini"; break;
+    case ProtocolHandler::SlowDown: file_name = "SlowDown.gemini"; break;
     }
     file_name = ":/error_page/" + file_name;
 
@@ -436,7 +477,88 @@ void BrowserTab::on_networkTimeout()
     if(this->current_handler != nullptr) {
         this->current_handler->cancelRequest();
     }
-    on_networkError(ProtocolHandler::Timeout, "The server didn't respond in time.");
+    on_networkError(ProtocolHandler::Timeout, this->network_timeout_reason);
+}
+
+void BrowserTab::on_coalescedRequestCompleted(const QString &key, const QByteArray &data, const QString &mime)
+{
+    if(not this->is_coalesce_waiter or (key != this->coalesced_key))
+        return;
+
+    this->coalesced_key.clear();
+    this->is_coalesce_waiter = false;
+
+    this->on_requestComplete(data, mime);
+}
+
+void BrowserTab::on_coalescedRequestAbandoned(const QString &key)
+{
+    if(not this->is_coalesce_waiter or (key != this->coalesced_key))
+        return;
+
+    this->coalesced_key.clear();
+    this->is_coalesce_waiter = false;
+
+    // The owning tab was told to slow down, so we wait as well
+    if(kristall::rate_limits.isThrottled(this->current_location.host())) {
+        this->holdRequest(this->current_location, ProtocolHandler::Default);
+        return;
+    }
+
+    // The owning tab didn't receive a document, so we
+    // have to perform the request on our own.
+    this->startNetworkTimeout(kristall::options.network_timeout, "The server didn't respond in time.");
+    if(not this->current_handler->startRequest(this->current_location.adjusted(QUrl::RemoveFragment), ProtocolHandler::Default)) {
+        setErrorMessage(QString("Failed to execute request to %1").arg(this->current_location.toString()));
+    }
+}
+
+void BrowserTab::on_outlineTimeout()
+{
+    // Headings are indexed by position, so this is a binary search instead of a walk over the outline
+    int const position = this->ui->text_browser->cursorForPosition(QPoint(0, 0)).position();
+    int const heading = this->outline.headingAt(position);
+    if(heading == this->current_heading)
+        return;
+    this->current_heading = heading;
+
+    emit this->outlineHeadingChanged(this->outline.headingIndex(heading));
+}
+
+void BrowserTab::on_throttleTimeout()
+{
+    qint64 remaining = kristall::rate_limits.remainingTime(this->throttled_url.host());
+    if(remaining <= 0)
+    {
+        this->startRequest(this->throttled_url, this->throttled_options, RequestFlags::DontReadFromCache);
+        return;
+    }
+
+    // Tick on full seconds, so the countdown stays in sync with the deadline
+    this->throttle_timer.start(int((remaining % 1000 == 0) ? 1000 : (remaining % 1000)));
+
+    QString page = QString(
+        "# Slow Down\n"
+        "\n"
+        "The server %1 asked Kristall to wait before sending another request.\n"
+        "\n"
+        "> The request will be sent again in %2 seconds.\n"
+    ).arg(this->throttled_url.host()).arg((remaining + 999) / 1000);
+
+    // The countdown isn't a loaded document, so it's rendered directly
+    // instead of going through the completion path of a request.
+    this->is_internal_location = true;
+    this->page_title = "";
+    this->renderPage(page.toUtf8(), MimeParser::parse("text/gemini"));
+    this->updatePageTitle();
+
+    if(this->request_state != RequestState::Throttled) {
+        this->updateMouseCursor(true);
+        emit this->requestStateChanged(RequestState::Throttled);
+        this->request_state = RequestState::Throttled;
+    }
+
+    this->updateUI();
 }
 
 void BrowserTab::on_focusSearchbar()
@@ -447,6 +569,7 @@ void BrowserTab::on_focusSearchbar()
 void BrowserTab::on_certificateRequired(const QString &reason)
 {
     this->network_timeout_timer.stop();
+    this->releaseCoalescedRequest();
 
     if (not trySetClientCertificate(reason))
     {
@@ -464,71 +587,6 @@ void BrowserTab::on_hostCertificateLoaded(const QSslCertificate &cert)
     this->current_server_certificate = cert;
 }
 
-static QByteArray convertToUtf8(QByteArray const & input, QString const & charSet)
-{
-    auto charset_u8 = charSet.toUpper().toUtf8();
-
-    // TRANSLIT will try to mix-match other code points to reflect to correct encoding
-    iconv_t cd = iconv_open("UTF-8", charset_u8.data());
-    if(cd == (iconv_t)-1) {
-        return QByteArray { };
-    }
-
-    QByteArray result;
-
-    char temp_buffer[4096];
-
-#if defined(__NetBSD__)
-    char const * input_ptr = reinterpret_cast<char const *>(input.data());
-#else
-    char * input_ptr = const_cast<char *>(reinterpret_cast<char const *>(input.data()));
-#endif
-    size_t input_size = input.size();
-
-    while(input_size > 0)
-    {
-        char * out_ptr = temp_buffer;
-        size_t out_size = sizeof(temp_buffer);
-
-        size_t n = iconv(cd, &input_ptr, &input_size, &out_ptr, &out_size);
-        if (n == size_t(-1))
-        {
-            if(errno == E2BIG) {
-                // silently ignore E2BIG, as we will continue conversion in the next loop
-            }
-            else if(errno == EILSEQ) {
-                // this is an invalid multibyte sequence.
-                // append an "replacement character" and skip a byte
-                if(input_size > 0) {
-                    input_size --;
-                    input_ptr++;
-                    result.append(u8"�");
-                }
-            }
-            else if(errno == EINVAL) {
-                // the file ends with an invalid multibyte sequence.
-                // just drop it and display the replacement-character
-                if(input_size > 0) {
-                    input_size --;
-                    input_ptr++;
-                    result.append(u8"�");
-                }
-            }
-            else {
-                perror("iconv conversion error");
-                break;
-            }
-        }
-
-        size_t len = out_ptr - temp_buffer;
-        result.append(temp_buffer, len);
-    }
-
-    iconv_close(cd);
-
-    return result;
-}
-
 void BrowserTab::on_requestComplete(const QByteArray &ref_data, const QString &mime_text)
 {
     MimeType mime = MimeParser::parse(mime_text);
@@ -547,10 +605,13 @@ void BrowserTab::on_requestComplete(const QByteArray &ref_data, const MimeType &
 //        qDebug() << key << mime.parameters[key];
 //    }
 
+    // Only convert if really required, so the body stays shared with the protocol handler and cache.
+    // US-ASCII is a subset of UTF-8 and needs no conversion.
     auto charset = mime.parameter("charset", "utf-8").toUpper();
-    if(not ref_data.isEmpty() and (mime.type == "text") and (charset != "UTF-8"))
+    if(not ref_data.isEmpty() and (mime.type == "text") and not IoUtil::isUtf8Compatible(charset))
     {
-        auto temp = convertToUtf8(ref_data, charset);
+        KRISTALL_TRACE("convert to utf-8", "render");
+        auto temp = IoUtil::convertToUtf8(ref_data, charset);
         bool ok = (temp.size() > 0);
         if(ok) {
             data = std::move(temp);
@@ -577,8 +638,41 @@ void BrowserTab::on_requestComplete(const QByteArray &ref_data, const MimeType &
 
     renderPage(data, mime);
 
+    if(this->pending_scroll_pos >= 0) {
+        this->ui->text_browser->verticalScrollBar()->setValue(this->pending_scroll_pos);
+        this->pending_scroll_pos = -1;
+    }
+
     this->updatePageTitle();
 
+    // Put file in cache if we are not in an internal
+    // location. Don't cache if we read this page from cache.
+    // We also do not cache if user has a client certificate enabled.
+    // Only text pages are cached, theme previews are rendered from a template.
+    bool const will_cache = mime.is("text") and not mime.is("text", "x-kristall-theme");
+
+    // History and search index are stored on disk, answers to
+    // sensitive input like passwords must not end up there.
+    bool const is_sensitive = this->is_sensitive_input and this->isInputLocation();
+
+    if (will_cache &&
+        !this->is_internal_location &&
+        !this->was_read_from_cache &&
+        !this->current_identity.isValid())
+    {
+        KRISTALL_TRACE("cache page", "cache");
+        kristall::cache.push(this->current_location, data, mime);
+
+        // Indexing happens in the background
+        if(not is_sensitive) {
+            kristall::search_index.addDocument(this->current_location, this->page_title, data, mime);
+        }
+    }
+
+    if(not this->is_internal_location and not is_sensitive) {
+        kristall::global_history.addVisit(this->current_location, this->page_title);
+    }
+
     this->updateUrlBarStyle();
 
     this->current_stats.file_size = ref_data.size();
@@ -593,8 +687,34 @@ void BrowserTab::on_requestComplete(const QByteArray &ref_data, const MimeType &
     this->request_state = RequestState::None;
 }
 
+//! Emojis are either encoded as 4 byte UTF-8 sequences or are in the
+//! "Miscellaneous Symbols" and "Dingbats" blocks (U+2600 - U+27BF).
+static bool mayContainEmoji(QByteArray const & data)
+{
+    for(int i = 0; i < data.size(); i++)
+    {
+        uint8_t const c = uint8_t(data[i]);
+        if(c >= 0xF0)
+            return true;
+        if((c == 0xE2) and (i + 1 < data.size())) {
+            uint8_t const next = uint8_t(data[i + 1]);
+            if(next >= 0x98 and next <= 0x9E)
+                return true;
+        }
+    }
+    return false;
+}
+
 void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
 {
+    KRISTALL_TRACE("render page", "render");
+
+    QElapsedTimer render_timer;
+    render_timer.start();
+
+    this->is_hibernated = false;
+    this->hibernated_buffer.clear();
+
     this->current_mime = mime;
     this->current_buffer = data;
 
@@ -621,46 +741,13 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
 
     bool plaintext_only = (kristall::options.text_display == GenericSettings::PlainText);
 
-    // Only cache text pages
-    bool will_cache = true;
-
-    if (not plaintext_only and mime.is("text", "gemini"))
+    // The emoji fonts are large, so they are only loaded once they're needed
+    if (kristall::EMOJIS_SUPPORTED and kristall::options.emojis_enabled and mime.is("text") and mayContainEmoji(data))
     {
-        document = GeminiRenderer::render(
-            data,
-            this->current_location,
-            doc_style,
-            this->outline,
-            &this->page_title);
-    }
-    else if (not plaintext_only and mime.is("text","gophermap"))
-    {
-        document = GophermapRenderer::render(
-            data,
-            this->current_location,
-            doc_style);
+        kristall::ensureEmojiFonts();
     }
-    else if (not plaintext_only and mime.is("text","html"))
-    {
-        document = std::make_unique<QTextDocument>();
-
-        document->setDefaultFont(doc_style.standard_font);
-        document->setDefaultStyleSheet(doc_style.toStyleSheet());
-        renderhelpers::setPageMargins(document.get(), doc_style.margin_h, doc_style.margin_v);
 
-        // Strip inline styles from page, so they don't
-        // conflict with user styles.
-        QString page_html = QString::fromUtf8(data);
-        page_html.replace(QRegularExpression("<style.*?>[\\S\\s]*?</style.*?>", QRegularExpression::CaseInsensitiveOption), "");
-
-        // Strip bgcolor attribute from body. These can screw up user styles too.
-        page_html.replace(QRegularExpression("<body.*bgcolor.*>", QRegularExpression::CaseInsensitiveOption), "<body>");
-
-        document->setHtml(page_html);
-
-        page_title = document->metaInformation(QTextDocument::DocumentTitle);
-    }
-    else if (not plaintext_only and mime.is("text","x-kristall-theme"))
+    if (not plaintext_only and mime.is("text","x-kristall-theme"))
     {
         // ugly workaround for QSettings needing a file
         QFile temp_file { kristall::dirs::cache_root.absoluteFilePath("preview-theme.kthm") };
@@ -689,22 +776,17 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
 
         this->ui->text_browser->setStyleSheet(QString("QTextBrowser { background-color: %1; color: %2; }")
             .arg(preview_style.background_color.name(), preview_style.standard_color.name()));
-
-        will_cache = false;
     }
-    else if (not plaintext_only and mime.is("text","markdown"))
+    else if (mime.is("text"))
     {
-        document = MarkdownRenderer::render(
+        document = renderhelpers::renderDocument(
             data,
+            mime,
             this->current_location,
             doc_style,
             this->outline,
             this->page_title);
     }
-    else if (mime.is("text"))
-    {
-        document = PlainTextRenderer::render(data, doc_style);
-    }
     else if (mime.is("image"))
     {
         doc_type = Image;
@@ -737,15 +819,11 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
         invoker->deleteLater();
 
         this->ui->graphics_browser->fitInView(graphics_scene.sceneRect(), Qt::KeepAspectRatio);
-
-        will_cache = false;
     }
     else if (mime.is("video") or mime.is("audio"))
     {
         doc_type = Media;
         this->ui->media_browser->setMedia(data, this->current_location, mime.type);
-
-        will_cache = false;
     }
     else if (plaintext_only)
     {
@@ -764,8 +842,6 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
         ).arg(mime.type, mime.subtype, IoUtil::size_human(data.size()));
 
         document->setPlainText(plain_data);
-
-        will_cache = false;
     }
     else
     {
@@ -789,8 +865,6 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
             doc_style,
             this->outline,
             &this->page_title);
-
-        will_cache = false;
     }
 
     assert((document != nullptr) == (doc_type == Text));
@@ -799,29 +873,35 @@ void BrowserTab::renderPage(const QByteArray &data, const MimeType &mime)
     this->ui->graphics_browser->setVisible(doc_type == Image);
     this->ui->media_browser->setVisible(doc_type == Media);
 
-    this->ui->text_browser->setDocument(document.get());
-    this->current_document = std::move(document);
-    this->current_style = std::move(doc_style);
-    this->updatePageMargins();
+    {
+        // Setting the document lays it out
+        KRISTALL_TRACE("layout", "render");
+        this->ui->text_browser->setDocument(document.get());
+        this->current_document = std::move(document);
+        this->current_style = std::move(doc_style);
+        this->updatePageMargins();
+    }
 
     this->needs_rerender = false;
 
+    this->current_heading = -1;
+    this->outline_timer.start();
+
+    // The matches refer to the previous document
+    this->search_snapshot = QString { };
+    if(this->ui->search_bar->isVisible()) {
+        this->startPageSearch();
+    }
+
     emit this->locationChanged(this->current_location);
 
     this->updateUI();
 
     this->updateUrlBarStyle();
 
-    // Put file in cache if we are not in an internal
-    // location. Don't cache if we read this page from cache.
-    // We also do not cache if user has a client certificate enabled.
-    if (will_cache &&
-        !this->is_internal_location &&
-        !this->was_read_from_cache &&
-        !this->current_identity.isValid())
-    {
-        kristall::cache.push(this->current_location, data, mime);
-    }
+    kristall::perf.addRender(mime.toString(false), render_timer.elapsed());
+
+    this->updateMemoryUsage();
 }
 
 void BrowserTab::rerenderPage()
@@ -834,6 +914,179 @@ void BrowserTab::rerenderPage()
     this->ui->text_browser->verticalScrollBar()->setValue(scroll);
 }
 
+bool BrowserTab::hibernate()
+{
+    if(this->is_hibernated)
+        return true;
+    if(not this->successfully_loaded or this->request_state != RequestState::None)
+        return false;
+    if(this->ui->media_browser->isPlaying())
+        return false;
+
+    qDebug() << "hibernating tab" << this->current_location;
+
+    this->hibernated_scroll = this->ui->text_browser->verticalScrollBar()->value();
+    this->hibernated_buffer = qCompress(this->current_buffer);
+    this->current_buffer = QByteArray { };
+
+    this->ui->text_browser->setDocument(nullptr);
+    this->current_document.reset();
+    this->graphics_scene.clear();
+    this->ui->media_browser->clearMedia();
+    this->page_search.cancel();
+    this->search_snapshot = QString { };
+    this->search_highlights.clear();
+    this->current_match = -1;
+
+    // The outline model is kept, so the outline stays usable
+    // without rendering the document again.
+    this->is_hibernated = true;
+    this->updateMemoryUsage();
+    return true;
+}
+
+bool BrowserTab::discardSnapshot()
+{
+    if(not this->is_hibernated or this->hibernated_buffer.isEmpty())
+        return false;
+
+    // Loading the page again would send the input to the server again
+    if(this->isInputLocation())
+        return false;
+
+    qDebug() << "discarding snapshot of" << this->current_location;
+
+    this->hibernated_buffer = QByteArray { };
+    this->updateMemoryUsage();
+    return true;
+}
+
+void BrowserTab::saveSession(QSettings &settings) const
+{
+    // Input may be sensitive or trigger an action on the server, so
+    // the tab is restored with the location that asked for it.
+    QUrl location = this->current_location;
+    if(this->isInputLocation()) {
+        location = location.adjusted(QUrl::RemoveQuery);
+    }
+
+    settings.setValue("url", location.toString(QUrl::FullyEncoded));
+    settings.setValue("title", this->page_title);
+    settings.setValue("scroll", this->is_hibernated
+        ? this->hibernated_scroll
+        : this->ui->text_browser->verticalScrollBar()->value());
+
+    QStringList history;
+    for(auto const & url : this->history.urls()) {
+        history.append(url.toString(QUrl::FullyEncoded));
+    }
+    settings.setValue("history", history);
+    settings.setValue("history_index", this->current_history_index.isValid() ? this->current_history_index.row() : -1);
+}
+
+bool BrowserTab::restoreSession(QSettings &settings)
+{
+    QUrl const location { settings.value("url").toString() };
+    if(not location.isValid() or location.isEmpty())
+        return false;
+
+    QVector<QUrl> history;
+    int history_index = settings.value("history_index", -1).toInt();
+    QStringList const stored_history = settings.value("history").toStringList();
+    for(int i = 0; i < stored_history.size(); i++)
+    {
+        QUrl const url { stored_history.at(i) };
+        if(url.isValid() and not url.isEmpty()) {
+            history.append(url);
+        } else if(i < history_index) {
+            history_index -= 1;
+        } else if(i == history_index) {
+            history_index = -1;
+        }
+    }
+    this->history.setUrls(history);
+
+    if(history_index >= 0 and history_index < history.size()) {
+        this->current_history_index = this->history.index(history_index);
+    } else {
+        this->current_history_index = QModelIndex { };
+    }
+
+    this->current_location = location;
+    this->page_title = settings.value("title").toString();
+    this->setUrlBarText(this->current_location.toString(QUrl::FullyEncoded));
+
+    // Behave like a tab that was hibernated and lost its snapshot,
+    // so the page is loaded when the tab is shown the first time.
+    this->is_hibernated = true;
+    this->hibernated_buffer = QByteArray { };
+    this->hibernated_scroll = settings.value("scroll", 0).toInt();
+
+    this->updateUI();
+    return true;
+}
+
+bool BrowserTab::isInputLocation() const
+{
+    return this->input_location.isValid()
+        and (this->current_location.adjusted(QUrl::RemoveFragment) == this->input_location);
+}
+
+void BrowserTab::updateMemoryUsage()
+{
+    // Rough estimate of the memory a layouted text document needs per character
+    static constexpr qint64 document_bytes_per_char = 16;
+
+    bool const is_media = this->current_mime.is("video") or this->current_mime.is("audio");
+
+    qint64 document_size = is_media ? 0 : this->current_buffer.size();
+    if(this->current_document != nullptr) {
+        document_size += document_bytes_per_char * this->current_document->characterCount();
+    }
+
+    qint64 image_size = 0;
+    for(auto * item : this->graphics_scene.items())
+    {
+        if(auto * pixmap_item = qgraphicsitem_cast<QGraphicsPixmapItem*>(item); pixmap_item != nullptr) {
+            QPixmap const & pixmap = pixmap_item->pixmap();
+            image_size += qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+        }
+    }
+
+    kristall::memory.setOwnerName(this, QString("Tab: %1").arg(this->page_title.isEmpty() ? this->current_location.toString() : this->page_title));
+    kristall::memory.account(MemoryGovernor::Documents, this, document_size);
+    kristall::memory.account(MemoryGovernor::Images, this, image_size);
+    kristall::memory.account(MemoryGovernor::Media, this, is_media ? this->current_buffer.size() : 0);
+    kristall::memory.account(MemoryGovernor::HibernatedTabs, this, this->is_hibernated ? this->hibernated_buffer.size() : 0);
+}
+
+void BrowserTab::wakeUp()
+{
+    if(not this->is_hibernated)
+        return;
+
+    qDebug() << "waking up tab" << this->current_location;
+
+    if(this->hibernated_buffer.isEmpty()) {
+        // The snapshot was discarded to save memory or the tab was restored from a session
+        this->is_hibernated = false;
+        if(not this->current_location.isValid() or this->current_location.isEmpty()) {
+            this->updateUI();
+            return;
+        }
+        this->pending_scroll_pos = this->hibernated_scroll;
+        this->navigateTo(this->current_location, DontPush);
+        return;
+    }
+
+    QByteArray data = qUncompress(this->hibernated_buffer);
+    int scroll = this->hibernated_scroll;
+
+    this->renderPage(data, this->current_mime);
+
+    this->ui->text_browser->verticalScrollBar()->setValue(scroll);
+}
+
 void BrowserTab::updatePageTitle()
 {
     if (page_title.isEmpty())
@@ -863,6 +1116,7 @@ void BrowserTab::updatePageTitle()
 void BrowserTab::on_inputRequired(const QString &query, const bool is_sensitive)
 {
     this->network_timeout_timer.stop();
+    this->releaseCoalescedRequest();
 
     QInputDialog dialog{this};
 
@@ -889,6 +1143,8 @@ void BrowserTab::on_inputRequired(const QString &query, const bool is_sensitive)
                 tr("Your input message is too long. Your input is %1 bytes, but a maximum of %2 bytes are allowed.\r\nPlease cancel or shorten your input.").arg(len).arg(1020)
             );
         } else {
+            this->input_location = new_location.adjusted(QUrl::RemoveFragment);
+            this->is_sensitive_input = is_sensitive;
             this->navigateTo(new_location, DontPush);
             break;
         }
@@ -897,9 +1153,8 @@ void BrowserTab::on_inputRequired(const QString &query, const bool is_sensitive)
 
 void BrowserTab::on_redirected(QUrl uri, bool is_permanent)
 {
-    Q_UNUSED(is_permanent);
-
     this->network_timeout_timer.stop();
+    this->releaseCoalescedRequest();
 
     // #79: Handle non-full url redirects
     if (uri.isRelative())
@@ -966,12 +1221,20 @@ void BrowserTab::on_redirected(QUrl uri, bool is_permanent)
             }
         }
 
+        QUrl const previous_location = this->current_location;
         if (this->startRequest(uri, ProtocolHandler::Default))
         {
             redirection_count += 1;
             this->current_location = uri;
             this->setUrlBarText(uri.toString(QUrl::FullyEncoded));
             this->history.replaceUrl(this->current_history_index.row(), uri);
+
+            if (is_permanent)
+            {
+                kristall::redirects.insert(previous_location, uri);
+                kristall::favourites.relocateUrl(previous_location, uri);
+                this->history.relocateUrl(previous_location, uri);
+            }
         }
         else
         {
@@ -1089,6 +1352,7 @@ void BrowserTab::on_text_browser_anchorClicked(const QUrl &url, bool open_in_new
                     return;
                 }
 
+                kristall::trust::ensureLoaded();
                 if(this->current_location.scheme() == "gemini") {
                     kristall::trust::gemini.addTrust(this->current_location, this->current_server_certificate);
                 }
@@ -1101,6 +1365,12 @@ void BrowserTab::on_text_browser_anchorClicked(const QUrl &url, bool open_in_new
 
                 this->startRequest(this->current_location, ProtocolHandler::Default);
             }
+            // Forget all cached permanent redirects
+            else if(not is_theme_preview and opt == "clear-redirects") {
+                kristall::redirects.clear();
+                kristall::saveSettings();
+                this->reloadPage();
+            }
             else if(opt == "install-theme") {
 
                 if(is_theme_preview)
@@ -1239,6 +1509,19 @@ void BrowserTab::on_text_browser_highlighted(const QUrl &url)
 
 void BrowserTab::on_stop_button_clicked()
 {
+    if(this->throttle_timer.isActive() or (this->request_state == RequestState::Throttled)) {
+        this->throttle_timer.stop();
+        this->updateMouseCursor(false);
+        emit this->requestStateChanged(RequestState::None);
+        this->request_state = RequestState::None;
+        setErrorMessage(QString("Request to %1 was cancelled while waiting for the server.").arg(this->throttled_url.toString()));
+    }
+    if(this->is_coalesce_waiter) {
+        this->updateMouseCursor(false);
+        emit this->requestStateChanged(RequestState::None);
+        this->request_state = RequestState::None;
+    }
+    this->releaseCoalescedRequest();
     if(this->current_handler != nullptr) {
         this->current_handler->cancelRequest();
     }
@@ -1250,16 +1533,72 @@ void BrowserTab::on_home_button_clicked()
     this->navigateTo(QUrl(kristall::options.start_page), BrowserTab::PushImmediate);
 }
 
+void BrowserTab::on_requestStateChange(RequestState state)
+{
+    RequestState const previous_state = this->request_state;
+
+    emit this->requestStateChanged(state);
+    this->request_state = state;
+
+    // Each phase of the request gets its own deadline. Phases that
+    // only depend on the network are derived from the round trip time
+    // to the host, so dead hosts fail fast.
+    QString const host = this->current_location.host();
+    qint64 const fallback = kristall::options.network_timeout;
+    switch(state)
+    {
+    case RequestState::Started:
+    case RequestState::HostFound:
+        this->startNetworkTimeout(
+            kristall::rtt.connectTimeout(host, fallback),
+            "Could not connect to the server in time.");
+        break;
+
+    case RequestState::Connected:
+        // The TCP handshake takes a single round trip
+        if(previous_state == RequestState::HostFound and this->current_handler != nullptr) {
+            qint64 const connect_time = this->current_handler->timings().between(RequestTimings::Resolved, RequestTimings::Connected);
+            if(connect_time >= 0) {
+                kristall::rtt.addSample(host, connect_time);
+            }
+        }
+
+        if(this->current_location.scheme() == "gemini") {
+            this->startNetworkTimeout(
+                kristall::rtt.handshakeTimeout(host, fallback),
+                "The TLS handshake with the server didn't complete in time.");
+        } else {
+            this->startNetworkTimeout(
+                kristall::rtt.firstByteTimeout(host, fallback),
+                "The server didn't respond in time.");
+        }
+        break;
+
+    case RequestState::Encrypted:
+        this->startNetworkTimeout(
+            kristall::rtt.firstByteTimeout(host, fallback),
+            "The server didn't respond in time.");
+        break;
+
+    default:
+        break;
+    }
+}
+
 void BrowserTab::on_requestProgress(qint64 transferred)
 {
+    if(this->current_handler != nullptr) {
+        this->current_stats.timings = this->current_handler->timings();
+    }
+
     this->current_stats.file_size = transferred;
     this->current_stats.mime_type = MimeType { };
     this->current_stats.loading_time = this->timer.elapsed();
     this->current_stats.loaded_from_cache = false;
     emit this->fileLoaded(this->current_stats);
 
-    this->network_timeout_timer.stop();
-    this->network_timeout_timer.start(kristall::options.network_timeout);
+    // As long as data is flowing, the transfer may take as long as it needs
+    this->startNetworkTimeout(kristall::options.network_timeout, "The server stopped sending data.");
 }
 
 void BrowserTab::on_back_button_clicked()
@@ -1277,7 +1616,7 @@ void BrowserTab::updateUI()
     this->ui->back_button->setEnabled(history.oneBackward(current_history_index).isValid());
     this->ui->forward_button->setEnabled(history.oneForward(current_history_index).isValid());
 
-    bool in_progress = (this->current_handler != nullptr) and this->current_handler->isInProgress();
+    bool in_progress = this->is_coalesce_waiter or this->throttle_timer.isActive() or ((this->current_handler != nullptr) and this->current_handler->isInProgress());
 
     this->ui->refresh_button->setVisible(not in_progress);
     this->ui->stop_button->setVisible(in_progress);
@@ -1483,13 +1822,69 @@ void BrowserTab::resetClientCertificate()
 
 void BrowserTab::addProtocolHandler(std::unique_ptr<ProtocolHandler> &&handler)
 {
+    // Must be connected before the other slots so the timings are known
+    // when the request result is processed.
+    auto * const handler_ptr = handler.get();
+    auto const record_timings = [this, handler_ptr]() {
+        this->current_stats.timings = handler_ptr->timings();
+        kristall::timing_log.add(this->current_location, handler_ptr->timings());
+
+        // Internal pages have no host and would only skew the statistics
+        qint64 const completed = handler_ptr->timings().get(RequestTimings::Completed);
+        if(completed >= 0 and not this->current_location.host().isEmpty()) {
+            kristall::perf.addFetch(this->current_location.host(), completed);
+        }
+    };
+    connect(handler_ptr, &ProtocolHandler::requestComplete, this, record_timings);
+    connect(handler_ptr, &ProtocolHandler::networkError, this, record_timings);
+
+    if(kristall::archive.isRecording())
+    {
+        // Also connected before the other slots, redirects change the current location
+        auto const record_response = [this, handler_ptr](int status, QString const & meta, QByteArray const & body, int error) {
+            if(this->is_internal_location)
+                return;
+            // The query of the location is the answer to a sensitive input, like a password
+            if(this->is_sensitive_input and this->isInputLocation())
+                return;
+            NetworkArchive::Entry entry;
+            entry.url = this->current_location.adjusted(QUrl::RemoveFragment);
+            entry.status = status;
+            entry.meta = meta;
+            entry.error = error;
+            entry.body = body;
+            entry.timings = handler_ptr->timings();
+            kristall::archive.record(entry);
+        };
+        connect(handler_ptr, &ProtocolHandler::requestComplete, this, [record_response](QByteArray const & data, QString const & mime) {
+            record_response(20, mime, data, 0);
+        });
+        connect(handler_ptr, &ProtocolHandler::redirected, this, [record_response](QUrl const & uri, bool is_permanent) {
+            record_response(is_permanent ? 31 : 30, uri.toString(QUrl::FullyEncoded), QByteArray { }, 0);
+        });
+        connect(handler_ptr, &ProtocolHandler::inputRequired, this, [record_response](QString const & query, bool is_sensitive) {
+            record_response(is_sensitive ? 11 : 10, query, QByteArray { }, 0);
+        });
+        connect(handler_ptr, &ProtocolHandler::certificateRequired, this, [record_response](QString const & info) {
+            record_response(60, info, QByteArray { }, 0);
+        });
+        connect(handler_ptr, &ProtocolHandler::networkError, this, [record_response](ProtocolHandler::NetworkError error, QString const & reason) {
+            record_response(0, reason, QByteArray { }, int(error));
+        });
+    }
+
     connect(handler.get(), &ProtocolHandler::requestProgress, this, &BrowserTab::on_requestProgress);
     connect(handler.get(), &ProtocolHandler::requestComplete, this,
         qOverload<QByteArray const &, QString const &>(&BrowserTab::on_requestComplete));
-    connect(handler.get(), &ProtocolHandler::requestStateChange, this, [this](RequestState state) {
-        emit this->requestStateChanged(state);
-        this->request_state = state;
+    connect(handler.get(), &ProtocolHandler::requestComplete, this, [this](QByteArray const & data, QString const & mime) {
+        // Hand the document over to all tabs waiting for the same request
+        if(not this->coalesced_key.isEmpty() and not this->is_coalesce_waiter) {
+            QString key = this->coalesced_key;
+            this->coalesced_key.clear();
+            kristall::coalescer.finish(key, this, data, mime);
+        }
     });
+    connect(handler.get(), &ProtocolHandler::requestStateChange, this, &BrowserTab::on_requestStateChange);
     connect(handler.get(), &ProtocolHandler::redirected, this, &BrowserTab::on_redirected);
     connect(handler.get(), &ProtocolHandler::inputRequired, this, &BrowserTab::on_inputRequired);
     connect(handler.get(), &ProtocolHandler::networkError, this, &BrowserTab::on_networkError);
@@ -1501,6 +1896,13 @@ void BrowserTab::addProtocolHandler(std::unique_ptr<ProtocolHandler> &&handler)
 
 bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions options, RequestFlags flags)
 {
+    this->releaseCoalescedRequest();
+    this->throttle_timer.stop();
+
+    this->current_options = options;
+
+    this->current_stats.timings = RequestTimings { };
+
     this->updateMouseCursor(true);
 
     this->current_server_certificate = QSslCertificate { };
@@ -1565,26 +1967,22 @@ bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions o
             this->disableClientCertificate();
         }
     }
-    else if(not this->current_identity.isValid()) {
-        for(auto ident_ptr : kristall::identities.allIdentities())
+    else if(not this->current_identity.isValid() and url.scheme() != "about" and url.scheme() != "file") {
+        // Local documents never need a client certificate, so the
+        // identities are only loaded for network requests.
+        kristall::ensureIdentitiesLoaded();
+        if(auto ident_ptr = kristall::identities.automaticIdentityFor(url))
         {
-            if(ident_ptr->isAutomaticallyEnabledOn(url)) {
-
-                auto answer = QMessageBox::question(
-                    this,
-                    "Kristall",
-                    tr("An automatic client certificate was detected for this site:\r\n%1\r\nDo you want to enable that certificate?")
-                        .arg(ident_ptr->display_name),
-                    QMessageBox::Yes | QMessageBox::No,
-                    QMessageBox::No
-                );
-                if(answer != QMessageBox::Yes) {
-                    break;
-                }
-
+            auto answer = QMessageBox::question(
+                this,
+                "Kristall",
+                tr("An automatic client certificate was detected for this site:\r\n%1\r\nDo you want to enable that certificate?")
+                    .arg(ident_ptr->display_name),
+                QMessageBox::Yes | QMessageBox::No,
+                QMessageBox::No
+            );
+            if(answer == QMessageBox::Yes) {
                 enableClientCertificate(*ident_ptr);
-
-                break;
             }
         }
     }
@@ -1598,11 +1996,38 @@ bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions o
     this->current_location = url;
     this->setUrlBarText(urlstr);
 
-    this->network_timeout_timer.start(kristall::options.network_timeout);
+    this->startNetworkTimeout(kristall::options.network_timeout, "The server didn't respond in time.");
 
     const auto req = [this, &url, &options]()
     {
-        return this->current_handler->startRequest(url.adjusted(QUrl::RemoveFragment), options);
+        // Don't send anything to a host that asked us to slow down
+        if(not this->is_internal_location and kristall::rate_limits.isThrottled(url.host()))
+        {
+            this->holdRequest(url, options);
+            return true;
+        }
+
+        // Interactive retries (ignoring TLS errors) are never shared with other tabs
+        if((options == ProtocolHandler::Default) and not this->is_internal_location)
+        {
+            this->coalesced_key = RequestCoalescer::keyFor(url, this->current_identity);
+            if(kristall::coalescer.join(this->coalesced_key, this) == RequestCoalescer::Waiter)
+            {
+                // Another tab is already fetching this document, so we
+                // wait for its result instead of requesting it again.
+                this->is_coalesce_waiter = true;
+                this->network_timeout_timer.stop();
+                emit this->requestStateChanged(RequestState::Started);
+                this->request_state = RequestState::Started;
+                return true;
+            }
+        }
+
+        bool ok = this->current_handler->startRequest(url.adjusted(QUrl::RemoveFragment), options);
+        if(not ok) {
+            this->releaseCoalescedRequest();
+        }
+        return ok;
     };
 
     if ((flags & RequestFlags::DontReadFromCache) ||
@@ -1613,7 +2038,9 @@ bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions o
 
     // Check if we have the page in our cache.
     kristall::cache.clean();
-    if (auto pg = kristall::cache.find(url); pg != nullptr)
+    auto pg = kristall::cache.find(url);
+    kristall::perf.addCacheLookup(url.host(), pg != nullptr);
+    if (pg != nullptr)
     {
         qDebug() << "Reading page from cache";
         this->was_read_from_cache = true;
@@ -1632,6 +2059,34 @@ bool BrowserTab::startRequest(const QUrl &url, ProtocolHandler::RequestOptions o
     }
 }
 
+void BrowserTab::startNetworkTimeout(qint64 timeout, const QString &reason)
+{
+    this->network_timeout_reason = reason;
+    this->network_timeout_timer.start(int(timeout));
+}
+
+void BrowserTab::holdRequest(const QUrl &url, ProtocolHandler::RequestOptions options)
+{
+    this->network_timeout_timer.stop();
+
+    this->throttled_url = url;
+    this->throttled_options = options;
+
+    this->on_throttleTimeout();
+}
+
+void BrowserTab::releaseCoalescedRequest()
+{
+    if(this->coalesced_key.isEmpty())
+        return;
+
+    QString key = this->coalesced_key;
+    this->coalesced_key.clear();
+    this->is_coalesce_waiter = false;
+
+    kristall::coalescer.leave(key, this);
+}
+
 void BrowserTab::updateMouseCursor(bool waiting)
 {
     if (waiting)
@@ -1662,28 +2117,97 @@ void BrowserTab::disableClientCertificate()
     this->current_identity = CryptoIdentity();
 }
 
-bool BrowserTab::searchBoxFind(QString text, bool backward)
+//! Highlighting is the slow part of searching, so only this many matches are highlighted
+static const int MAX_SEARCH_HIGHLIGHTS = 5000;
+
+void BrowserTab::startPageSearch()
 {
-    // First we escape the query to be suitable to use inside a regex pattern.
-    // https://stackoverflow.com/a/3561711
-    static const QRegularExpression ESCAPE_REGEX = QRegularExpression(R"(([-\/\\^$*+?.()|[\]{}]))");
-    text.replace(ESCAPE_REGEX, "\\\\1");
+    this->current_match = -1;
+    this->search_highlights.clear();
+    this->ui->text_browser->setExtraSelections(this->search_highlights);
 
-    // This part allows us to match different types of quotes easily:
-    // ' -> ('|‘|’)
-    // " -> ("|“|”)
-    static const QRegularExpression QUOTES_SINGLE_REGEX = QRegularExpression("'");
-    static const QRegularExpression QUOTES_DOUBLE_REGEX = QRegularExpression("\"");
-    text.replace(QUOTES_SINGLE_REGEX, "('|‘|’)").replace(QUOTES_DOUBLE_REGEX, "(\"|“|”)");
+    QString needle = this->ui->search_box->text();
+    if(needle.isEmpty()) {
+        this->page_search.cancel();
+        this->updateSearchCount();
+        return;
+    }
 
-    // Perform search using our new regex
-    return this->ui->text_browser->find(
-#if (QT_VERSION >= QT_VERSION_CHECK(5, 13, 0))
-        QRegularExpression(text, QRegularExpression::CaseInsensitiveOption),
-#else
-        QRegExp(text, Qt::CaseInsensitive),
-#endif
-        backward ? QTextDocument::FindBackward : QTextDocument::FindFlags());
+    if(this->search_snapshot.isNull()) {
+        this->search_snapshot = this->ui->text_browser->document()->toPlainText();
+    }
+
+    // The snapshot is implicitly shared with the search job
+    this->page_search.start(this->search_snapshot, needle);
+    this->updateSearchCount();
+}
+
+void BrowserTab::selectMatch(int index)
+{
+    auto const & matches = this->page_search.matches();
+    if(matches.isEmpty())
+        return;
+
+    int const count = matches.size();
+    this->current_match = ((index % count) + count) % count;
+
+    QTextCursor cursor { this->ui->text_browser->document() };
+    cursor.setPosition(matches.at(this->current_match));
+    cursor.setPosition(matches.at(this->current_match) + this->page_search.matchLength(), QTextCursor::KeepAnchor);
+    this->ui->text_browser->setTextCursor(cursor);
+    this->ui->text_browser->ensureCursorVisible();
+
+    this->updateSearchCount();
+}
+
+void BrowserTab::updateSearchCount()
+{
+    int const count = this->page_search.matches().size();
+    bool const running = this->page_search.isRunning();
+
+    QString text;
+    if(this->ui->search_box->text().isEmpty())
+        text = "";
+    else if(count == 0)
+        text = running ? tr("Searching…") : tr("No matches");
+    else
+        text = tr("%1 of %2%3").arg(this->current_match + 1).arg(count).arg(running ? "+" : "");
+    this->ui->search_count->setText(text);
+}
+
+void BrowserTab::on_pageSearchMatches(int first)
+{
+    auto const & matches = this->page_search.matches();
+
+    QColor color = this->palette().color(QPalette::Highlight);
+    color.setAlpha(96);
+
+    QTextCharFormat format;
+    format.setBackground(color);
+
+    QTextDocument * document = this->ui->text_browser->document();
+    int const length = this->page_search.matchLength();
+    for(int i = first; i < matches.size() and this->search_highlights.size() < MAX_SEARCH_HIGHLIGHTS; i++)
+    {
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor { document };
+        selection.cursor.setPosition(matches.at(i));
+        selection.cursor.setPosition(matches.at(i) + length, QTextCursor::KeepAnchor);
+        selection.format = format;
+        this->search_highlights.append(selection);
+    }
+    this->ui->text_browser->setExtraSelections(this->search_highlights);
+
+    if(this->current_match < 0) {
+        this->selectMatch(0);
+    } else {
+        this->updateSearchCount();
+    }
+}
+
+void BrowserTab::on_pageSearchFinished()
+{
+    this->updateSearchCount();
 }
 
 void BrowserTab::on_text_browser_customContextMenuRequested(const QPoint pos)
@@ -1780,40 +2304,34 @@ void BrowserTab::on_enable_client_cert_button_clicked(bool checked)
 
 void BrowserTab::on_search_box_textChanged(const QString &arg1)
 {
-    this->ui->text_browser->setTextCursor(QTextCursor { this->ui->text_browser->document() });
-    this->searchBoxFind(arg1);
+    Q_UNUSED(arg1)
+    this->startPageSearch();
 }
 
 void BrowserTab::on_search_box_returnPressed()
 {
-    this->searchBoxFind(this->ui->search_box->text());
+    this->on_search_next_clicked();
 }
 
 void BrowserTab::on_search_next_clicked()
 {
-    if (!this->searchBoxFind(this->ui->search_box->text()) &&
-        this->current_buffer.contains(this->ui->search_box->text().toUtf8()))
-    {
-        // Wrap search
-        this->ui->text_browser->moveCursor(QTextCursor::Start);
-        this->searchBoxFind(this->ui->search_box->text());
-    }
+    this->selectMatch(this->current_match + 1);
 }
 
 void BrowserTab::on_search_previous_clicked()
 {
-    if (!this->searchBoxFind(this->ui->search_box->text(), true) &&
-        this->current_buffer.contains(this->ui->search_box->text().toUtf8()))
-    {
-        // Wrap search
-        this->ui->text_browser->moveCursor(QTextCursor::End);
-        this->searchBoxFind(this->ui->search_box->text(), true);
-    }
+    // Without a selected match, searching backwards starts at the end
+    this->selectMatch(this->current_match < 0 ? -1 : this->current_match - 1);
 }
 
 void BrowserTab::on_close_search_clicked()
 {
     this->ui->search_bar->setVisible(false);
+
+    this->page_search.cancel();
+    this->search_highlights.clear();
+    this->ui->text_browser->setExtraSelections(this->search_highlights);
+    this->current_match = -1;
 }
 
 void BrowserTab::resizeEvent(QResizeEvent *event)
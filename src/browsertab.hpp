@@ -10,6 +10,8 @@
 #include <QElapsedTimer>
 #include <QTimer>
 #include <QTextCursor>
+#include <QTextEdit>
+#include <QSettings>
 
 #include "documentoutlinemodel.hpp"
 #include "tabbrowsinghistory.hpp"
@@ -18,6 +20,8 @@
 #include "cryptoidentity.hpp"
 
 #include "protocolhandler.hpp"
+#include "requesttimings.hpp"
+#include "pagesearch.hpp"
 
 #include "mimeparser.hpp"
 
@@ -32,6 +36,7 @@ enum class UIDensity : int;
 struct DocumentStats
 {
     int loading_time = 0; // in ms
+    RequestTimings timings; // phase breakdown of the network request
     MimeType mime_type;
     qint64 file_size = 0;
     bool loaded_from_cache = false;
@@ -93,6 +98,34 @@ public:
 
     void rerenderPage();
 
+    //! Releases the rendered document, images and media of a background tab.
+    //! Only the compressed source of the page is kept, so the tab can be
+    //! rendered again with wakeUp(). Returns false if the tab can't hibernate.
+    bool hibernate();
+
+    //! Renders a hibernated tab again from the kept source.
+    void wakeUp();
+
+    bool isHibernated() const {
+        return this->is_hibernated;
+    }
+
+    //! Drops the snapshot of a hibernated tab. The page is loaded
+    //! again when the tab is woken up.
+    bool discardSnapshot();
+
+    //! Stores location, title, history and scroll position of the tab.
+    void saveSession(QSettings & settings) const;
+
+    //! Restores a tab stored with saveSession(). The tab starts out
+    //! hibernated, so the page is only loaded when the tab is shown.
+    //! Returns false if the stored location is invalid.
+    bool restoreSession(QSettings & settings);
+
+    //! Returns true if the query of the current location is the answer
+    //! to an input prompt of the server.
+    bool isInputLocation() const;
+
     void updatePageTitle();
 
     void refreshFavButton();
@@ -116,6 +149,8 @@ signals:
     void locationChanged(QUrl const & url);
     void fileLoaded(DocumentStats const & stats);
     void requestStateChanged(RequestState state);
+    //! The heading at the top of the viewport changed, `index` is an index in `outline`.
+    void outlineHeadingChanged(QModelIndex const & index);
 
 private slots:
     void on_url_bar_returnPressed();
@@ -162,6 +197,7 @@ private slots:
 
 private: // network slots
 
+    void on_requestStateChange(RequestState state);
     void on_requestProgress(qint64 transferred);
     void on_requestComplete(QByteArray const & data, QString const & mime);
     void on_requestComplete(QByteArray const & data, MimeType const & mime);
@@ -173,9 +209,20 @@ private: // network slots
 
     void on_networkTimeout();
 
+    void on_coalescedRequestCompleted(QString const & key, QByteArray const & data, QString const & mime);
+    void on_coalescedRequestAbandoned(QString const & key);
+
+    void on_throttleTimeout();
+
+    void on_outlineTimeout();
+
 private: // ui slots
     void on_focusSearchbar();
 
+    void on_pageSearchMatches(int first);
+
+    void on_pageSearchFinished();
+
 private:
     void setErrorMessage(QString const & msg);
 
@@ -196,12 +243,27 @@ private:
 
     bool startRequest(QUrl const & url, ProtocolHandler::RequestOptions options, RequestFlags flags = RequestFlags::None);
 
+    void releaseCoalescedRequest();
+
+    void holdRequest(QUrl const & url, ProtocolHandler::RequestOptions options);
+
+    void startNetworkTimeout(qint64 timeout, QString const & reason);
+
     void updateMouseCursor(bool waiting);
 
     bool enableClientCertificate(CryptoIdentity const & ident);
     void disableClientCertificate();
 
-    bool searchBoxFind(QString text, bool backward=false);
+    //! Searches the text of the search box in the current document.
+    void startPageSearch();
+
+    //! Selects and scrolls to the match at `index`, wraps around at both ends.
+    void selectMatch(int index);
+
+    void updateSearchCount();
+
+    //! Reports the memory used by this tab to the memory governor.
+    void updateMemoryUsage();
 
 protected:
     void resizeEvent(QResizeEvent * event);
@@ -218,6 +280,8 @@ public:
 
     int redirection_count = 0;
 
+    int slow_down_count = 0;
+
     bool successfully_loaded = false;
 
     DocumentOutlineModel outline;
@@ -239,11 +303,47 @@ public:
     DocumentStats current_stats;
 
     QTimer network_timeout_timer;
-
-    QTextCursor current_search_position;
+    QString network_timeout_reason;
+
+    //! Key of the coalesced request this tab currently owns or waits for.
+    QString coalesced_key;
+    bool is_coalesce_waiter = false;
+
+    //! Fires when a request held back by a rate limited host should be sent.
+    QTimer throttle_timer;
+    QUrl throttled_url;
+    ProtocolHandler::RequestOptions throttled_options = ProtocolHandler::Default;
+    ProtocolHandler::RequestOptions current_options = ProtocolHandler::Default;
+
+    //! Limits updates of the outline heading while scrolling to one per frame
+    QTimer outline_timer;
+    //! Number of the heading at the top of the viewport, see DocumentOutlineModel::headingAt
+    int current_heading = -1;
+
+    PageSearch page_search;
+    //! Plain text of the current document, created when it's searched the first time
+    QString search_snapshot;
+    QList<QTextEdit::ExtraSelection> search_highlights;
+    //! Index of the selected match in page_search.matches(), -1 if none
+    int current_match = -1;
 
     bool needs_rerender;
 
+    //! Measures the time since the tab was last shown to the user.
+    QElapsedTimer last_active;
+
+    bool is_hibernated = false;
+    QByteArray hibernated_buffer;
+    int hibernated_scroll = 0;
+
+    //! Scroll position that is applied when the next page has loaded, -1 if none.
+    int pending_scroll_pos = -1;
+
+    //! Location with the last answer to an input prompt as query. These
+    //! are never requested again without the user asking for it.
+    QUrl input_location;
+    bool is_sensitive_input = false;
+
     QString page_title;
 
     bool no_url_style = false;
@@ -6,6 +6,8 @@
 
 void CacheHandler::push(const QUrl &url, const QByteArray &body, const MimeType &mime)
 {
+    KRISTALL_TRACE("cache push", "cache");
+
     // Skip if this item is above the cached item size threshold
     int bodysize = body.size();
     if (bodysize > (kristall::options.cache_threshold * 1024))
@@ -26,14 +28,18 @@ void CacheHandler::push(const QUrl &url, const QByteArray &body, const MimeType
     {
         qDebug() << "cache: updating page";
         auto pg = this->page_cache[urlstr];
+        this->total_size += body.size() - pg->body.size();
         pg->body = body;
         pg->mime = mime;
         pg->time_cached = QDateTime::currentDateTime();
+        this->updateMemoryUsage();
         return;
     }
 
     this->page_cache[urlstr] = std::make_shared<CachedPage>(
         url, body, mime, QDateTime::currentDateTime());
+    this->total_size += body.size();
+    this->updateMemoryUsage();
 
     qDebug() << "cache: pushing url " << url;
 
@@ -42,6 +48,8 @@ void CacheHandler::push(const QUrl &url, const QByteArray &body, const MimeType
 
 std::shared_ptr<CachedPage> CacheHandler::find(const QString &url)
 {
+    KRISTALL_TRACE("cache find", "cache");
+
     if (this->page_cache.find(url) != this->page_cache.end())
     {
         return this->page_cache[url];
@@ -64,19 +72,11 @@ bool CacheHandler::contains(const QUrl &url)
     return this->contains(url.toString(QUrl::FullyEncoded | QUrl::RemoveFragment));
 }
 
-int CacheHandler::size()
-{
-    int s = 0;
-
-    for (auto& i : this->page_cache)
-        s += i.second->body.size();
-
-    return s;
-}
-
 // Clears expired pages out of cache
 void CacheHandler::clean()
 {
+    KRISTALL_TRACE("cache clean", "cache");
+
     // Don't clean anything if we have unlimited item life.
     if (kristall::options.cache_unlimited_life) return;
 
@@ -96,11 +96,27 @@ void CacheHandler::clean()
     int count = 0;
     for (auto&& key : vec)
     {
-        this->page_cache.erase(key);
+        auto it = this->page_cache.find(key);
+        this->total_size -= it->second->body.size();
+        this->page_cache.erase(it);
         ++count;
     }
 
     if (count) qDebug() << "cache: cleaned " << count << " expired pages out of cache";
+
+    this->updateMemoryUsage();
+}
+
+qint64 CacheHandler::evict(qint64 bytes)
+{
+    KRISTALL_TRACE("cache evict", "cache");
+
+    qint64 const initial_size = this->size();
+    while (this->page_cache.size() > 0 and (initial_size - this->size()) < bytes)
+    {
+        this->popOldest();
+    }
+    return initial_size - this->size();
 }
 
 CacheMap const& CacheHandler::getPages() const
@@ -121,18 +137,25 @@ void CacheHandler::popOldest()
     //
     // (TODO: make this more efficient somehow?)
 
-    QDateTime oldest = QDateTime::currentDateTime();
-    QString oldest_key;
+    auto oldest = this->page_cache.begin();
     for (auto it = this->page_cache.begin(); it != this->page_cache.end(); ++it)
     {
-        if (it->second->time_cached < oldest)
+        if (it->second->time_cached < oldest->second->time_cached)
         {
-            oldest = it->second->time_cached;
-            oldest_key = it->first;
+            oldest = it;
         }
     }
 
     // Erase it from the map
-    qDebug() << "cache: popping " << oldest_key;
-    this->page_cache.erase(oldest_key);
+    qDebug() << "cache: popping " << oldest->first;
+    this->total_size -= oldest->second->body.size();
+    this->page_cache.erase(oldest);
+
+    this->updateMemoryUsage();
+}
+
+void CacheHandler::updateMemoryUsage()
+{
+    kristall::memory.setOwnerName(this, "Page cache");
+    kristall::memory.account(MemoryGovernor::PageCache, this, this->size());
 }
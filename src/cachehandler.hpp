@@ -60,10 +60,21 @@ public:
 
     bool contains(QUrl const & url);
 
-    int size();
+    //! Returns the size of all cached bodies in bytes.
+    qint64 size() const {
+        return this->total_size;
+    }
+
+    int pageCount() const {
+        return int(this->page_cache.size());
+    }
 
     void clean();
 
+    //! Drops the oldest pages until at least `bytes` bytes were freed.
+    //! Returns the number of bytes freed.
+    qint64 evict(qint64 bytes);
+
     CacheMap const& getPages() const;
 
 private:
@@ -73,9 +84,14 @@ private:
 
     void popOldest();
 
+    void updateMemoryUsage();
+
 private:
     // In-memory cache storage.
     CacheMap page_cache;
+
+    //! Sum of the body sizes in `page_cache`, kept up to date on every change
+    qint64 total_size = 0;
 };
 
 #endif
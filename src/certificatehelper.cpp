@@ -57,15 +57,15 @@ CryptoIdentity CertificateHelper::createNewIdentity(const QString &common_name,
     const char * buffer = nullptr;
     size_t size = BIO_get_mem_data(bp_public, &buffer);
     q_check_ptr(buffer);
-    identity.certificate = QSslCertificate(QByteArray(buffer, size));
-    if(identity.certificate.isNull())
+    identity.setCertificate(QSslCertificate(QByteArray(buffer, size)));
+    if(identity.certificate().isNull())
     {
         qFatal("Failed to generate a random client certificate");
     }
     size = BIO_get_mem_data(bp_private, &buffer);
     q_check_ptr(buffer);
-    identity.private_key = QSslKey(QByteArray(buffer, size), QSsl::Rsa);
-    if(identity.private_key.isNull())
+    identity.setPrivateKey(QSslKey(QByteArray(buffer, size), QSsl::Rsa));
+    if(identity.privateKey().isNull())
     {
         qFatal("Failed to generate a random private key");
     }
@@ -1,19 +1,135 @@
 #include "cryptoidentity.hpp"
 
 #include <QUrl>
-#include <QRegExp>
+#include <QCryptographicHash>
 #include <cassert>
 
+struct CryptoIdentity::KeyMaterial
+{
+    QByteArray certificate_der;
+    QByteArray private_key_der;
+    QSsl::KeyAlgorithm algorithm = QSsl::Rsa;
+    QString fingerprint;
+
+    mutable bool certificate_decoded = false;
+    mutable QSslCertificate certificate;
+
+    mutable bool private_key_decoded = false;
+    mutable QSslKey private_key;
+};
+
+QSslCertificate const & CryptoIdentity::certificate() const
+{
+    static QSslCertificate const null_certificate;
+    if(not this->material)
+        return null_certificate;
+
+    auto & m = *this->material;
+    if(not m.certificate_decoded) {
+        m.certificate = QSslCertificate { m.certificate_der, QSsl::Der };
+        m.certificate_decoded = true;
+    }
+    return m.certificate;
+}
+
+QSslKey const & CryptoIdentity::privateKey() const
+{
+    static QSslKey const null_key;
+    if(not this->material)
+        return null_key;
+
+    auto & m = *this->material;
+    if(not m.private_key_decoded) {
+        m.private_key = QSslKey { m.private_key_der, m.algorithm, QSsl::Der, QSsl::PrivateKey };
+        m.private_key_decoded = true;
+    }
+    return m.private_key;
+}
+
+void CryptoIdentity::setCertificate(const QSslCertificate &certificate)
+{
+    auto m = std::make_shared<KeyMaterial>();
+    if(this->material) {
+        m->private_key_der = this->material->private_key_der;
+        m->algorithm = this->material->algorithm;
+        m->private_key_decoded = this->material->private_key_decoded;
+        m->private_key = this->material->private_key;
+    }
+    m->certificate_der = certificate.toDer();
+    m->fingerprint = QCryptographicHash::hash(m->certificate_der, QCryptographicHash::Sha256).toHex(':');
+    m->certificate_decoded = true;
+    m->certificate = certificate;
+    this->material = std::move(m);
+}
+
+void CryptoIdentity::setPrivateKey(const QSslKey &private_key)
+{
+    auto m = std::make_shared<KeyMaterial>();
+    if(this->material) {
+        m->certificate_der = this->material->certificate_der;
+        m->fingerprint = this->material->fingerprint;
+        m->certificate_decoded = this->material->certificate_decoded;
+        m->certificate = this->material->certificate;
+    }
+    m->private_key_der = private_key.toDer();
+    m->algorithm = private_key.algorithm();
+    m->private_key_decoded = true;
+    m->private_key = private_key;
+    this->material = std::move(m);
+}
+
+void CryptoIdentity::setEncoded(const QByteArray &certificate, const QByteArray &private_key, QSsl::KeyAlgorithm algorithm)
+{
+    auto m = std::make_shared<KeyMaterial>();
+    m->certificate_der = certificate;
+    m->private_key_der = private_key;
+    m->algorithm = algorithm;
+    // Hashing is cheap compared to parsing, so the fingerprint is available without decoding
+    m->fingerprint = QCryptographicHash::hash(certificate, QCryptographicHash::Sha256).toHex(':');
+    this->material = std::move(m);
+}
+
+QByteArray CryptoIdentity::certificateDer() const
+{
+    if(not this->material)
+        return QByteArray { };
+    return this->material->certificate_der;
+}
+
+QByteArray CryptoIdentity::privateKeyDer() const
+{
+    if(not this->material)
+        return QByteArray { };
+    return this->material->private_key_der;
+}
+
+QSsl::KeyAlgorithm CryptoIdentity::keyAlgorithm() const
+{
+    if(not this->material)
+        return QSsl::Rsa;
+    return this->material->algorithm;
+}
+
+bool CryptoIdentity::hasMaterial() const
+{
+    return this->material
+        and (not this->material->certificate_der.isEmpty())
+        and (not this->material->private_key_der.isEmpty());
+}
+
+QString CryptoIdentity::fingerprint() const
+{
+    if(not this->material)
+        return QString { };
+    return this->material->fingerprint;
+}
+
 bool CryptoIdentity::isHostFiltered(const QUrl &url) const
 {
     if(this->host_filter.isEmpty())
         return false;
 
-    QString url_text = url.toString(QUrl::FullyEncoded);
-
-    QRegExp pattern { this->host_filter, Qt::CaseInsensitive, QRegExp::Wildcard };
-
-    return not pattern.exactMatch(url_text);
+    return not this->hostPattern().exactMatch(url.toString(QUrl::FullyEncoded));
 }
 
 bool CryptoIdentity::isAutomaticallyEnabledOn(const QUrl &url) const
@@ -23,9 +139,13 @@ bool CryptoIdentity::isAutomaticallyEnabledOn(const QUrl &url) const
     if(not this->auto_enable)
         return false;
 
-    QString url_text = url.toString(QUrl::FullyEncoded);
-
-    QRegExp pattern { this->host_filter, Qt::CaseInsensitive, QRegExp::Wildcard };
+    return this->hostPattern().exactMatch(url.toString(QUrl::FullyEncoded));
+}
 
-    return pattern.exactMatch(url_text);
+QRegExp const & CryptoIdentity::hostPattern() const
+{
+    if(this->host_pattern.pattern() != this->host_filter) {
+        this->host_pattern = QRegExp { this->host_filter, Qt::CaseInsensitive, QRegExp::Wildcard };
+    }
+    return this->host_pattern;
 }
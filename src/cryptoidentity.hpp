@@ -5,17 +5,16 @@
 
 #include <QSslCertificate>
 #include <QSslKey>
+#include <QRegExp>
+
+#include <memory>
 
 //! Cryptographic user identitiy consisting
 //! of a key-certificate pair and some user information.
+//! The key material is shared between copies of an identity and
+//! stored identities are only decoded when the material is first used.
 struct CryptoIdentity
 {
-    //! The certificate that is used for cryptography
-    QSslCertificate certificate;
-
-    //! The actual private key that is used for cryptography
-    QSslKey private_key;
-
     //! The title with which the identity is presented to the user.
     QString display_name;
 
@@ -32,15 +31,58 @@ struct CryptoIdentity
     //! the certificate will be automatically enabled for hosts matching the filter.
     bool auto_enable = false;
 
+    //! The certificate that is used for cryptography
+    QSslCertificate const & certificate() const;
+
+    //! The actual private key that is used for cryptography
+    QSslKey const & privateKey() const;
+
+    void setCertificate(QSslCertificate const & certificate);
+
+    void setPrivateKey(QSslKey const & private_key);
+
+    //! Sets the DER encoded key material without decoding it.
+    void setEncoded(QByteArray const & certificate, QByteArray const & private_key, QSsl::KeyAlgorithm algorithm);
+
+    //! Returns the DER encoded certificate, decoding stored identities isn't necessary for this.
+    QByteArray certificateDer() const;
+
+    //! Returns the DER encoded private key, decoding stored identities isn't necessary for this.
+    QByteArray privateKeyDer() const;
+
+    //! Returns the algorithm of the private key, decoding stored identities isn't necessary for this.
+    QSsl::KeyAlgorithm keyAlgorithm() const;
+
+    //! Returns the SHA256 fingerprint of the certificate, see toFingerprintString().
+    QString fingerprint() const;
+
+    //! Returns true if certificate and private key decode successfully.
+    //! This decodes the key material of stored identities.
     bool isValid() const {
-        return (not this->certificate.isNull()) and (not this->private_key.isNull());
+        return (not this->certificate().isNull()) and (not this->privateKey().isNull());
     }
 
+    //! Returns true if the identity has encoded key material, without decoding it.
+    bool hasMaterial() const;
+
     //! returns true if a host does not match the filter criterion
     bool isHostFiltered(QUrl const & url) const;
 
     //! returns true when the identity should be enabled on url
     bool isAutomaticallyEnabledOn(QUrl const & url) const;
+
+    //! Returns the compiled host_filter wildcard pattern.
+    QRegExp const & hostPattern() const;
+
+private:
+    struct KeyMaterial;
+
+    //! Cache for hostPattern(), recompiled when host_filter changes
+    mutable QRegExp host_pattern;
+
+    //! Never modified after it was created except for decoding, so copies
+    //! of an identity can share it. Setters replace it instead.
+    std::shared_ptr<KeyMaterial> material;
 };
 
 #endif // CRYPTOIDENTITIY_HPP
@@ -59,10 +59,10 @@ void CertificateManagementDialog::on_certificates_selected(QModelIndex const& in
         auto & cert = *selected_identity;
         this->ui->groupBox->setEnabled(true);
         this->ui->cert_display_name->setText(cert.display_name);
-        this->ui->cert_common_name->setText(cert.certificate.subjectInfo(QSslCertificate::CommonName).join(", "));
-        this->ui->cert_expiration_date->setDateTime(cert.certificate.expiryDate());
-        this->ui->cert_livetime->setText(QString("%1 days").arg(QDateTime::currentDateTime().daysTo(cert.certificate.expiryDate())));
-        this->ui->cert_fingerprint->setPlainText(toFingerprintString(cert.certificate));
+        this->ui->cert_common_name->setText(cert.certificate().subjectInfo(QSslCertificate::CommonName).join(", "));
+        this->ui->cert_expiration_date->setDateTime(cert.certificate().expiryDate());
+        this->ui->cert_livetime->setText(QString("%1 days").arg(QDateTime::currentDateTime().daysTo(cert.certificate().expiryDate())));
+        this->ui->cert_fingerprint->setPlainText(cert.fingerprint());
         this->ui->cert_notes->setPlainText(cert.user_notes);
 
         this->ui->cert_host_filter->setText(cert.host_filter);
@@ -146,7 +146,7 @@ void CertificateManagementDialog::on_export_cert_button_clicked()
         return;
     CertificateIoDialog dialog { this };
 
-    dialog.setKeyAlgorithm(this->selected_identity->private_key.algorithm());
+    dialog.setKeyAlgorithm(this->selected_identity->privateKey().algorithm());
     dialog.setIoMode(CertificateIoDialog::Export);
 
     if(dialog.exec() != QDialog::Accepted)
@@ -165,9 +165,9 @@ void CertificateManagementDialog::on_export_cert_button_clicked()
 
         QByteArray cert_blob;
         if(dialog.certificateFileName().endsWith(".der")) {
-            cert_blob = this->selected_identity->certificate.toDer();
+            cert_blob = this->selected_identity->certificateDer();
         } else {
-            cert_blob = this->selected_identity->certificate.toPem();
+            cert_blob = this->selected_identity->certificate().toPem();
         }
 
         if(not IoUtil::writeAll(cert_file, cert_blob)) {
@@ -193,9 +193,9 @@ void CertificateManagementDialog::on_export_cert_button_clicked()
 
         QByteArray key_blob;
         if(dialog.keyFileName().endsWith(".der")) {
-            key_blob = this->selected_identity->private_key.toDer();
+            key_blob = this->selected_identity->privateKeyDer();
         } else {
-            key_blob = this->selected_identity->private_key.toPem();
+            key_blob = this->selected_identity->privateKey().toPem();
         }
 
         if(not IoUtil::writeAll(key_file, key_blob)) {
@@ -239,23 +239,23 @@ void CertificateManagementDialog::on_import_cert_button_clicked()
     }
 
     CryptoIdentity ident;
-    ident.private_key = QSslKey {
+    ident.setPrivateKey(QSslKey {
         &key_file,
         dialog.keyAlgorithm(),
         dialog.keyFileName().endsWith(".der") ? QSsl::Der : QSsl::Pem,
         QSsl::PrivateKey
-    };
-    ident.certificate = QSslCertificate {
+    });
+    ident.setCertificate(QSslCertificate {
         &cert_file,
         dialog.keyFileName().endsWith(".der") ? QSsl::Der : QSsl::Pem,
-    };
+    });
     ident.user_notes = tr("Imported from:\r\nkey: %1\r\n:cert: %2").arg(dialog.keyFileName(), dialog.certificateFileName());
     ident.display_name = "Imported Certificate";
     ident.auto_enable = false;
     ident.host_filter = "";
     ident.is_persistent = true;
 
-    if(ident.private_key.isNull()) {
+    if(ident.privateKey().isNull()) {
         QMessageBox::warning(
             this,
             "Kristall",
@@ -264,7 +264,7 @@ void CertificateManagementDialog::on_import_cert_button_clicked()
         return;
     }
 
-    if(ident.certificate.isNull()) {
+    if(ident.certificate().isNull()) {
         QMessageBox::warning(
             this,
             "Kristall",
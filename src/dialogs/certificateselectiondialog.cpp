@@ -16,6 +16,7 @@ CertificateSelectionDialog::CertificateSelectionDialog(QWidget *parent) :
     ui->setupUi(this);
     this->ui->server_request->setVisible(false);
 
+    kristall::ensureIdentitiesLoaded();
     this->ui->certificates->setModel(&kristall::identities);
     this->ui->certificates->expandAll();
 
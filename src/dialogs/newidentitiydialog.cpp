@@ -19,6 +19,7 @@ NewIdentitiyDialog::NewIdentitiyDialog(QWidget *parent) :
     ui->expiration_date->setTime(QTime(12, 00));
 
     ui->group->clear();
+    kristall::ensureIdentitiesLoaded();
     for(const auto &group_name : kristall::identities.groups())
     {
         ui->group->addItem(group_name);
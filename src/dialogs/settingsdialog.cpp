@@ -350,6 +350,11 @@ void SettingsDialog::setOptions(const GenericSettings &options)
     this->ui->cache_life->setValue(this->current_options.cache_life);
     this->ui->enable_unlimited_cache_life->setChecked(this->current_options.cache_unlimited_life);
     this->ui->cache_life->setEnabled(!this->current_options.cache_unlimited_life);
+
+    this->ui->tab_hibernation_timeout->setValue(this->current_options.tab_hibernation_timeout);
+    this->ui->memory_budget->setValue(this->current_options.memory_budget);
+    this->ui->search_index_limit->setValue(this->current_options.search_index_limit);
+    this->ui->restore_session->setChecked(this->current_options.restore_session);
 }
 
 GenericSettings SettingsDialog::options() const
@@ -931,3 +936,23 @@ void SettingsDialog::on_enable_unlimited_cache_life_clicked(bool checked)
     this->current_options.cache_unlimited_life = checked;
     this->ui->cache_life->setEnabled(!checked);
 }
+
+void SettingsDialog::on_tab_hibernation_timeout_valueChanged(int timeout)
+{
+    this->current_options.tab_hibernation_timeout = timeout;
+}
+
+void SettingsDialog::on_memory_budget_valueChanged(int budget)
+{
+    this->current_options.memory_budget = budget;
+}
+
+void SettingsDialog::on_search_index_limit_valueChanged(int limit)
+{
+    this->current_options.search_index_limit = limit;
+}
+
+void SettingsDialog::on_restore_session_clicked(bool checked)
+{
+    this->current_options.restore_session = checked;
+}
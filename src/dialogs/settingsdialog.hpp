@@ -170,6 +170,14 @@ private slots:
     void on_cache_life_valueChanged(int life);
     void on_enable_unlimited_cache_life_clicked(bool checked);
 
+    void on_tab_hibernation_timeout_valueChanged(int timeout);
+
+    void on_memory_budget_valueChanged(int budget);
+
+    void on_search_index_limit_valueChanged(int limit);
+
+    void on_restore_session_clicked(bool checked);
+
 private:
     void reloadStylePreview();
 
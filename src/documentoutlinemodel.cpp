@@ -1,6 +1,7 @@
 #include "documentoutlinemodel.hpp"
 #include <cassert>
 #include <QModelIndex>
+#include <algorithm>
 
 DocumentOutlineModel::DocumentOutlineModel() :
     QAbstractItemModel(),
@@ -25,9 +26,10 @@ void DocumentOutlineModel::beginBuild()
         0, 0,
         QList<Node> { },
     };
+    positions.clear();
 }
 
-void DocumentOutlineModel::appendH1(const QString &title, QString const & anchor)
+void DocumentOutlineModel::appendH1(const QString &title, QString const & anchor, int position)
 {
     root.children.append(Node {
         &root,
@@ -35,9 +37,10 @@ void DocumentOutlineModel::appendH1(const QString &title, QString const & anchor
         1, 0,
         QList<Node> { },
     });
+    appendPosition(root.children.last(), position);
 }
 
-void DocumentOutlineModel::appendH2(const QString &title, QString const & anchor)
+void DocumentOutlineModel::appendH2(const QString &title, QString const & anchor, int position)
 {
     auto & parent = ensureLevel1();
     parent.children.append(Node {
@@ -46,9 +49,10 @@ void DocumentOutlineModel::appendH2(const QString &title, QString const & anchor
         2, parent.children.size() - 1,
         QList<Node> { },
     });
+    appendPosition(parent.children.last(), position);
 }
 
-void DocumentOutlineModel::appendH3(const QString &title, QString const & anchor)
+void DocumentOutlineModel::appendH3(const QString &title, QString const & anchor, int position)
 {
     auto & parent = ensureLevel2();
     parent.children.append(Node {
@@ -57,6 +61,7 @@ void DocumentOutlineModel::appendH3(const QString &title, QString const & anchor
         3, parent.children.size() - 1,
         QList<Node> { },
     });
+    appendPosition(parent.children.last(), position);
 }
 
 void DocumentOutlineModel::endBuild()
@@ -113,6 +118,22 @@ QString DocumentOutlineModel::getAnchor(const QModelIndex &index) const
     return childItem->anchor;
 }
 
+int DocumentOutlineModel::headingAt(int position) const
+{
+    auto it = std::upper_bound(positions.begin(), positions.end(), position, [](int pos, HeadingPosition const & heading) {
+        return pos < heading.position;
+    });
+    return int(it - positions.begin()) - 1;
+}
+
+QModelIndex DocumentOutlineModel::headingIndex(int heading) const
+{
+    if(heading < 0 or heading >= positions.size())
+        return QModelIndex();
+    Node const * node = positions.at(heading).node;
+    return createIndex(node->index, 0, reinterpret_cast<quintptr>(node));
+}
+
 QModelIndex DocumentOutlineModel::index(int row, int column, const QModelIndex &parent) const
 {
     if (not hasIndex(row, column, parent))
@@ -212,3 +233,10 @@ DocumentOutlineModel::Node & DocumentOutlineModel::ensureLevel2()
 
     return parent.children.last();
 }
+
+void DocumentOutlineModel::appendPosition(const Node &node, int position)
+{
+    // QList allocates nodes of this size on the heap, so the pointer stays valid while appending
+    assert(positions.isEmpty() or positions.last().position <= position);
+    positions.append(HeadingPosition { position, &node });
+}
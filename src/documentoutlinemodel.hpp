@@ -3,6 +3,7 @@
 
 #include <QAbstractItemModel>
 #include <QList>
+#include <QVector>
 
 class DocumentOutlineModel :
     public QAbstractItemModel
@@ -15,17 +16,26 @@ public:
 
     void beginBuild();
 
-    void appendH1(QString const & title, QString const & anchor);
+    //! `position` is the position of the heading in the rendered document,
+    //! headings must be appended in document order.
+    void appendH1(QString const & title, QString const & anchor, int position);
 
-    void appendH2(QString const & title, QString const & anchor);
+    void appendH2(QString const & title, QString const & anchor, int position);
 
-    void appendH3(QString const & title, QString const & anchor);
+    void appendH3(QString const & title, QString const & anchor, int position);
 
     void endBuild();
 
     QString getTitle(QModelIndex const & index) const;
     QString getAnchor(QModelIndex const & index) const;
 
+    //! Returns the number of the last heading at or before `position`,
+    //! or -1 if the position is before the first heading.
+    int headingAt(int position) const;
+
+    //! Returns the model index of the heading with the number `heading`.
+    QModelIndex headingIndex(int heading) const;
+
 public:
     QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
 
@@ -50,6 +60,17 @@ private:
 
     Node root;
 
+    struct HeadingPosition
+    {
+        int position;
+        Node const * node;
+    };
+
+    //! All headings sorted by their position in the document
+    QVector<HeadingPosition> positions;
+
+    void appendPosition(Node const & node, int position);
+
     Node & ensureLevel1();
     Node & ensureLevel2();
 };
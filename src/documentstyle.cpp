@@ -208,6 +208,8 @@ QString DocumentStyle::createFileNameFromName(const QString &src, int index)
 
 bool DocumentStyle::save(QSettings &settings) const
 {
+    KRISTALL_TRACE("save style", "settings");
+
     settings.setValue("version", 1);
     settings.setValue("theme", int(theme));
 
@@ -292,6 +294,8 @@ bool DocumentStyle::save(QSettings &settings) const
 
 bool DocumentStyle::load(QSettings &settings)
 {
+    KRISTALL_TRACE("load style", "settings");
+
     switch(settings.value("version", 0).toInt())
     {
     case 0: {
@@ -416,6 +420,8 @@ bool DocumentStyle::load(QSettings &settings)
 
 DocumentStyle DocumentStyle::derive(const QUrl &url) const
 {
+    KRISTALL_TRACE("derive style", "render");
+
     DocumentStyle themed = *this;
 
     // Patch font lists to allow improved emoji display:
@@ -444,8 +450,9 @@ DocumentStyle DocumentStyle::derive(const QUrl &url) const
         // We ensure that the font family is available first,
         // so that we don't get an ugly default font
         // (fixes Windows' default font problem)
-        QFontDatabase db;
-        if (!db.families().contains(font.family()))
+        // Enumerating the font families is expensive, so it's done once
+        static QStringList const families = QFontDatabase().families();
+        if (!families.contains(font.family()))
         {
             emojiFonts.front() = fixed
                 ? kristall::default_font_family_fixed
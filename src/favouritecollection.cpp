@@ -182,6 +182,7 @@ bool FavouriteCollection::renameGroup(const QString &old_name, const QString &ne
     if (to_set)
     {
         to_set->title = new_name;
+        this->invalidate();
         return true;
     }
 
@@ -213,22 +214,15 @@ void FavouriteCollection::editFavouriteTitle(const QModelIndex &index, const QSt
     this->getMutableFavourite(index)->title = title;
 }
 
-bool FavouriteCollection::editFavouriteTitle(const QUrl &u, const QString &new_title)
+bool FavouriteCollection::editFavouriteTitle(const QUrl &url, const QString &new_title)
 {
-    QUrl url = IoUtil::uniformUrl(u);
-    for(auto const & group : this->root.children)
-    {
-        for(auto const & ident : group->children)
-        {
-            FavouriteNode* node = &ident->as<FavouriteNode>();
-            if(IoUtil::uniformUrl(node->favourite.destination) == url)
-            {
-                node->favourite.title = new_title;
-                return true;
-            }
-        }
-    }
-    return false;
+    FavouriteNode * node = this->findNode(url);
+    if(node == nullptr)
+        return false;
+
+    node->favourite.title = new_title;
+    this->invalidate();
+    return true;
 }
 
 void FavouriteCollection::editFavouriteDest(const QModelIndex &index, const QUrl &url)
@@ -236,48 +230,34 @@ void FavouriteCollection::editFavouriteDest(const QModelIndex &index, const QUrl
     this->getMutableFavourite(index)->destination = url;
 }
 
-bool FavouriteCollection::editFavouriteGroup(const QUrl &u, const QString &group_name)
+bool FavouriteCollection::editFavouriteGroup(const QUrl &url, const QString &group_name)
 {
     // Find and erase favourite node
-    QUrl url = IoUtil::uniformUrl(u);
-    for (auto const & group : this->root.children)
-    {
-        size_t index = 0;
-        for (auto it = group->children.begin(); it != group->children.end(); it++, index++)
-        {
-            auto& fav = it->get()->as<FavouriteNode>();
-            if(IoUtil::uniformUrl(fav.favourite.destination) == url)
-            {
-                Favourite f = Favourite {
-                    fav.favourite.title,
-                    fav.favourite.destination
-                };
-
-                beginRemoveRows(this->index(fav.parent->index, 0), index, index + 1);
-                group->children.erase(it);
-                endRemoveRows();
-                this->relayout();
-
-                this->addFavourite(group_name, f);
-                return true;
-            }
-        }
-    }
-    return false;
+    FavouriteNode * fav = this->findNode(url);
+    if(fav == nullptr)
+        return false;
+
+    Favourite f = Favourite {
+        fav->favourite.title,
+        fav->favourite.destination
+    };
+
+    Node * group = fav->parent;
+    int index = fav->index;
+
+    beginRemoveRows(this->index(group->index, 0), index, index + 1);
+    group->children.erase(group->children.begin() + index);
+    endRemoveRows();
+    this->relayout();
+
+    this->addFavourite(group_name, f);
+    return true;
 }
 
-Favourite FavouriteCollection::getFavourite(const QUrl &u) const
+Favourite FavouriteCollection::getFavourite(const QUrl &url) const
 {
-    QUrl url = IoUtil::uniformUrl(u);
-    for(auto const & group : this->root.children)
-    {
-        for(auto const & ident : group->children)
-        {
-            FavouriteNode* node = &ident->as<FavouriteNode>();
-            if(IoUtil::uniformUrl(node->favourite.destination) == url)
-                return node->favourite;
-        }
-    }
+    if(FavouriteNode const * node = this->findNode(url))
+        return node->favourite;
     return Favourite();
 }
 
@@ -305,6 +285,9 @@ Favourite * FavouriteCollection::getMutableFavourite(const QModelIndex &index)
     if (index.column() != 0)
         return nullptr;
 
+    // The caller may change the favourite
+    this->invalidate();
+
     Node *item = static_cast<Node*>(index.internalPointer());
     switch(item->type) {
     case Node::Favourite: return &static_cast<FavouriteNode *>(item)->favourite;
@@ -315,15 +298,8 @@ Favourite * FavouriteCollection::getMutableFavourite(const QModelIndex &index)
 
 QString FavouriteCollection::groupForFavourite(const QUrl &url) const
 {
-    for (auto const & group : this->root.children)
-    {
-        for (auto const & ident : group->children)
-        {
-            FavouriteNode* node = &ident->as<FavouriteNode>();
-            if (node->favourite.destination == url)
-                return node->parent->as<GroupNode>().title;
-        }
-    }
+    if(FavouriteNode const * node = this->findNode(url))
+        return node->parent->as<GroupNode>().title;
     return QString { };
 }
 
@@ -366,6 +342,7 @@ bool FavouriteCollection::destroyFavourite(const QModelIndex &index)
     beginRemoveRows(this->parent(index), index.row(), index.row() + 1);
 
     parent->children.erase(parent->children.begin() + childItem->index);
+    this->relayout();
 
     endRemoveRows();
 
@@ -399,6 +376,7 @@ bool FavouriteCollection::deleteGroup(const QString &group_name)
             beginRemoveRows(QModelIndex { }, index, index + 1);
 
             root.children.erase(it);
+            this->relayout();
 
             endRemoveRows();
 
@@ -425,6 +403,7 @@ bool FavouriteCollection::deleteGroupRecursive(const QString &group_name)
             // Delete the group
             beginRemoveRows(QModelIndex { }, index, index + 1);
             root.children.erase(it);
+            this->relayout();
             endRemoveRows();
 
             return true;
@@ -451,18 +430,9 @@ QVector<QPair<QString, Favourite const *>> FavouriteCollection::allFavourites()
     return identities;
 }
 
-bool FavouriteCollection::containsUrl(const QUrl &u) const
+bool FavouriteCollection::containsUrl(const QUrl &url) const
 {
-    QUrl url = IoUtil::uniformUrl(u);
-    for(auto const & group : this->root.children)
-    {
-        for(auto const & ident : group->children)
-        {
-            if(IoUtil::uniformUrl(ident->as<FavouriteNode>().favourite.destination) == url)
-                return true;
-        }
-    }
-    return false;
+    return (this->findNode(url) != nullptr);
 }
 
 bool FavouriteCollection::addUnsorted(const QUrl &url, const QString &t)
@@ -475,27 +445,50 @@ bool FavouriteCollection::addUnsorted(const QUrl &url, const QString &t)
     });
 }
 
-bool FavouriteCollection::removeUrl(const QUrl &u)
+bool FavouriteCollection::removeUrl(const QUrl &url)
+{
+    FavouriteNode * fav = this->findNode(url);
+    if(fav == nullptr)
+        return false;
+
+    Node * group = fav->parent;
+    int index = fav->index;
+
+    beginRemoveRows(this->index(group->index, 0), index, index + 1);
+
+    group->children.erase(group->children.begin() + index);
+    this->relayout();
+
+    endRemoveRows();
+
+    return true;
+}
+
+bool FavouriteCollection::relocateUrl(const QUrl &old_url, const QUrl &new_url)
 {
-    QUrl url = IoUtil::uniformUrl(u);
+    // Permanent redirects are common, favourites pointing to them are not
+    if(not this->containsUrl(old_url))
+        return false;
+
+    QUrl url = IoUtil::uniformUrl(old_url);
+    bool relocated = false;
     for(auto const & group : this->root.children)
     {
-        size_t index = 0;
-        for(auto it = group->children.begin(); it != group->children.end(); ++it, ++index)
+        for(auto const & ident : group->children)
         {
-            auto & fav = it->get()->as<FavouriteNode>();
+            auto & fav = ident->as<FavouriteNode>();
             if(IoUtil::uniformUrl(fav.favourite.destination) == url) {
-                beginRemoveRows(QModelIndex { }, index, index + 1);
-
-                group->children.erase(it);
+                fav.favourite.destination = new_url;
 
-                endRemoveRows();
+                auto index = createIndex(fav.index, 0, &fav);
+                emit this->dataChanged(index, index);
 
-                return true;
+                relocated = true;
             }
         }
     }
-    return false;
+    this->invalidate();
+    return relocated;
 }
 
 QModelIndex FavouriteCollection::index(int row, int column, const QModelIndex &parent) const
@@ -606,10 +599,12 @@ bool FavouriteCollection::setData(const QModelIndex &index, const QVariant &valu
         case Node::Root: return false;
         case Node::Group:
             item->as<GroupNode>().title = value.toString();
+            this->invalidate();
             emit this->dataChanged(index, index, { Qt::EditRole });
             return true;
         case Node::Favourite:
             item->as<FavouriteNode>().favourite.title = value.toString();
+            this->invalidate();
             emit this->dataChanged(index, index, { Qt::EditRole });
             return true;
         default: return false;
@@ -773,6 +768,7 @@ bool FavouriteCollection::removeRows(int row, int count, const QModelIndex &pare
 
         beginRemoveRows(parent, row, row + 1);
         children.erase(children.begin() + size_t(row));
+        this->relayout();
         endRemoveRows();
 
         return true;
@@ -802,6 +798,36 @@ void FavouriteCollection::relayout()
             // qDebug() << "id[" << id.index << "]" << id.as<IdentityNode>().identity.display_name;
         }
     }
+
+    this->invalidate();
+}
+
+void FavouriteCollection::invalidate()
+{
+    this->current_revision += 1;
+    this->url_index_dirty = true;
+}
+
+FavouriteCollection::FavouriteNode * FavouriteCollection::findNode(const QUrl &url) const
+{
+    if(this->url_index_dirty)
+    {
+        this->url_index.clear();
+        for(auto const & group : this->root.children)
+        {
+            for(auto const & ident : group->children)
+            {
+                auto & node = ident->as<FavouriteNode>();
+                QString key = IoUtil::uniformUrlString(node.favourite.destination);
+                // Keep the first favourite like a linear search would
+                if(not this->url_index.contains(key))
+                    this->url_index.insert(key, &node);
+            }
+        }
+        this->url_index_dirty = false;
+    }
+
+    return this->url_index.value(IoUtil::uniformUrlString(url), nullptr);
 }
 
 bool FavouriteCollection::internalAddGroup(const QString &group_name, GroupNode * & group)
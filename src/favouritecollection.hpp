@@ -6,6 +6,7 @@
 #include <QString>
 #include <memory>
 #include <QSettings>
+#include <QHash>
 
 struct Favourite
 {
@@ -116,6 +117,15 @@ public:
 
     bool removeUrl(QUrl const & url);
 
+    //! Changes the destination of all favourites pointing to `old_url` to `new_url`.
+    bool relocateUrl(QUrl const & old_url, QUrl const & new_url);
+
+    //! Returns a number that changes whenever the collection is changed.
+    //! Can be used to cache data derived from the favourites.
+    quint64 revision() const {
+        return this->current_revision;
+    }
+
 public:
     // Header:
     // QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -150,10 +160,23 @@ public:
 private:
     void relayout();
 
+    //! Must be called after every change to the favourites
+    void invalidate();
+
+    //! Returns the first favourite pointing to `url` or `nullptr`.
+    FavouriteNode * findNode(QUrl const & url) const;
+
     bool internalAddGroup(QString const & group_name, GroupNode * & out_group);
 
 private:
     RootNode root;
+
+    quint64 current_revision = 0;
+
+    //! Maps uniform url strings to the first favourite with that url,
+    //! rebuilt on the first lookup after a change.
+    mutable QHash<QString, FavouriteNode *> url_index;
+    mutable bool url_index_dirty = true;
 };
 
 #endif // FAVOURITECOLLECTION_HPP
@@ -0,0 +1,395 @@
+#include "globalhistory.hpp"
+#include "ioutil.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThreadPool>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QDebug>
+
+#include <algorithm>
+#include <vector>
+
+//! Substring matching needs a scan over all entries, so it's
+//! only done for longer texts and stops after this time.
+static const int MIN_SUBSTRING_LENGTH = 3;
+static const int SUBSTRING_BUDGET = 10; // ms
+
+//! Prefix matches are always ranked above substring matches
+static const double PREFIX_BONUS = 1e9;
+
+static QByteArray encodeRecord(qint64 time, int visits, QString const & url, QString title)
+{
+    // Records are single lines with tab separated fields
+    title.replace('\t', ' ');
+    title.replace('\n', ' ');
+    title.replace('\r', ' ');
+
+    QByteArray record;
+    record.append(QByteArray::number(time));
+    record.append('\t');
+    record.append(QByteArray::number(visits));
+    record.append('\t');
+    record.append(url.toUtf8());
+    record.append('\t');
+    record.append(title.toUtf8());
+    record.append('\n');
+    return record;
+}
+
+GlobalHistory::GlobalHistory(QObject *parent) : QObject(parent)
+{
+
+}
+
+void GlobalHistory::setLogFile(const QString &file_name)
+{
+    this->log_file = file_name;
+}
+
+void GlobalHistory::load()
+{
+    if(this->loading or this->loaded)
+        return;
+
+    if(this->log_file.isEmpty()) {
+        this->loaded = true;
+        return;
+    }
+
+    // Visits are appended to the log while it's loaded, they are already
+    // in memory, so the loader only reads what was written before
+    auto job = new GlobalHistoryLoader(this->log_file, QFileInfo(this->log_file).size());
+    connect(job, &GlobalHistoryLoader::finished, this, [this, job]() {
+        this->on_loaderFinished(job->store);
+    }, Qt::QueuedConnection);
+
+    this->loading = true;
+    QThreadPool::globalInstance()->start(job);
+}
+
+void GlobalHistory::addVisit(const QUrl &url, const QString &title)
+{
+    if(not url.isValid())
+        return;
+
+    // Must be started before writing, so the loader doesn't read the visit again
+    this->load();
+
+    QString url_text = IoUtil::uniformUrlString(url);
+    qint64 now = QDateTime::currentSecsSinceEpoch();
+
+    if(not this->log_file.isEmpty())
+    {
+        QFile file { this->log_file };
+        if(file.open(QFile::WriteOnly | QFile::Append)) {
+            file.write(encodeRecord(now, 1, url_text, title));
+            this->store.log_records += 1;
+        } else {
+            qDebug() << "failed to write history to" << this->log_file << file.errorString();
+        }
+    }
+
+    this->store.insert(url_text, title, 1, now);
+}
+
+QVector<GlobalHistory::Entry> GlobalHistory::complete(const QString &text, int limit)
+{
+    this->load();
+    this->store.index();
+
+    QString needle = text.trimmed().toLower();
+    if(needle.isEmpty() or limit <= 0)
+        return QVector<Entry> { };
+
+    qint64 const now = QDateTime::currentSecsSinceEpoch();
+
+    auto const & entries = this->store.entries;
+    auto const & prefix_index = this->store.prefix_index;
+
+    // Short prefixes like "g" match almost every entry, so only the best
+    // `limit` prefix matches are kept while scanning, the worst one on top.
+    // Each url is indexed with and without scheme, so an entry can match twice.
+    using Candidate = std::pair<double, int>;
+    auto const is_better = [](Candidate const & a, Candidate const & b) {
+        return a.first > b.first;
+    };
+    std::vector<Candidate> best;
+    QSet<int> in_best;
+
+    auto it = std::lower_bound(prefix_index.begin(), prefix_index.end(), needle, [this](IndexKey const & key, QString const & value) {
+        return this->store.keyText(key).compare(value) < 0;
+    });
+    for(; it != prefix_index.end(); ++it)
+    {
+        if(not this->store.keyText(*it).startsWith(needle))
+            break;
+        if(in_best.contains(it->entry))
+            continue;
+
+        double const entry_score = score(entries.at(it->entry), now);
+        if(int(best.size()) >= limit)
+        {
+            if(entry_score <= best.front().first)
+                continue;
+            std::pop_heap(best.begin(), best.end(), is_better);
+            in_best.remove(best.back().second);
+            best.pop_back();
+        }
+        best.emplace_back(entry_score, it->entry);
+        std::push_heap(best.begin(), best.end(), is_better);
+        in_best.insert(it->entry);
+    }
+
+    QHash<int, double> scores;
+    for(auto const & candidate : best)
+        scores.insert(candidate.second, PREFIX_BONUS + candidate.first);
+
+    if(scores.size() < limit and needle.size() >= MIN_SUBSTRING_LENGTH)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        // Newer entries are more likely to be relevant, so they are searched first
+        for(int i = entries.size() - 1; i >= 0; i--)
+        {
+            if(scores.size() >= 4 * limit or timer.elapsed() > SUBSTRING_BUDGET)
+                break;
+            if(scores.contains(i))
+                continue;
+            if(this->store.keys.at(i).contains(needle) or entries.at(i).title.contains(needle, Qt::CaseInsensitive))
+                scores.insert(i, score(entries.at(i), now));
+        }
+    }
+
+    QVector<int> ranked;
+    ranked.reserve(scores.size());
+    for(auto s = scores.begin(); s != scores.end(); ++s)
+        ranked.append(s.key());
+
+    int const count = std::min(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [&scores](int a, int b) {
+        return scores.value(a) > scores.value(b);
+    });
+
+    QVector<Entry> result;
+    result.reserve(count);
+    for(int i = 0; i < count; i++)
+        result.append(entries.at(ranked.at(i)));
+    return result;
+}
+
+QVector<GlobalHistory::Entry> GlobalHistory::recent(int count)
+{
+    this->load();
+
+    auto const & entries = this->store.entries;
+
+    QVector<int> ids;
+    ids.reserve(entries.size());
+    for(int i = 0; i < entries.size(); i++)
+        ids.append(i);
+
+    count = std::max(0, std::min(count, ids.size()));
+    std::partial_sort(ids.begin(), ids.begin() + count, ids.end(), [&entries](int a, int b) {
+        return entries.at(a).last_visit > entries.at(b).last_visit;
+    });
+
+    QVector<Entry> result;
+    result.reserve(count);
+    for(int i = 0; i < count; i++)
+        result.append(entries.at(ids.at(i)));
+    return result;
+}
+
+void GlobalHistory::clear()
+{
+    // A running loader would bring the old entries back
+    this->store = Store { };
+    this->loading = false;
+    this->loaded = true;
+
+    if(not this->log_file.isEmpty())
+        QFile::remove(this->log_file);
+}
+
+int GlobalHistory::size()
+{
+    this->load();
+    return this->store.entries.size();
+}
+
+void GlobalHistory::on_loaderFinished(Store &store)
+{
+    if(not this->loading)
+        return;
+    this->loading = false;
+    this->loaded = true;
+
+    // The visits of this session are newer than the log
+    Store session = std::move(this->store);
+    this->store = std::move(store);
+    this->store.log_records += session.log_records;
+    for(auto const & entry : qAsConst(session.entries))
+        this->store.insert(entry.url, entry.title, entry.visits, entry.last_visit);
+
+    if(this->store.log_records > 2 * this->store.entries.size() + 1024) {
+        this->compact();
+    }
+}
+
+void GlobalHistory::Store::read(const QString &file_name, qint64 size)
+{
+    QFile file { file_name };
+    if(not file.open(QFile::ReadOnly))
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    this->log_records = 0;
+    while(not file.atEnd() and file.pos() < size)
+    {
+        QByteArray line = file.readLine();
+        if(line.endsWith('\n'))
+            line.chop(1);
+
+        auto fields = line.split('\t');
+        if(fields.size() != 4) {
+            // A crash while appending can leave a broken last line
+            continue;
+        }
+        this->log_records += 1;
+
+        bool time_ok, visits_ok;
+        qint64 time = fields[0].toLongLong(&time_ok);
+        int visits = fields[1].toInt(&visits_ok);
+        if(not time_ok or not visits_ok or fields[2].isEmpty())
+            continue;
+
+        this->insert(QString::fromUtf8(fields[2]), QString::fromUtf8(fields[3]), visits, time);
+    }
+    file.close();
+
+    this->index();
+
+    qDebug() << "loaded" << this->entries.size() << "history entries in" << timer.elapsed() << "ms";
+}
+
+void GlobalHistory::Store::index()
+{
+    if(this->unindexed.isEmpty())
+        return;
+
+    QVector<IndexKey> added;
+    added.reserve(2 * this->unindexed.size());
+    for(int id : this->unindexed)
+    {
+        added.append(IndexKey { id, 0 });
+
+        // Allows completing urls without typing the scheme
+        int scheme_end = this->keys.at(id).indexOf("://");
+        if(scheme_end >= 0)
+            added.append(IndexKey { id, scheme_end + 3 });
+    }
+    this->unindexed.clear();
+
+    auto less = [this](IndexKey const & a, IndexKey const & b) {
+        return this->keyText(a) < this->keyText(b);
+    };
+
+    std::sort(added.begin(), added.end(), less);
+
+    int const old_size = this->prefix_index.size();
+    this->prefix_index.append(added);
+    std::inplace_merge(this->prefix_index.begin(), this->prefix_index.begin() + old_size, this->prefix_index.end(), less);
+}
+
+void GlobalHistory::Store::insert(const QString &url, const QString &title, int visits, qint64 time)
+{
+    auto it = this->index_by_url.constFind(url);
+    if(it != this->index_by_url.constEnd())
+    {
+        auto & entry = this->entries[*it];
+        entry.visits += visits;
+        if(time >= entry.last_visit) {
+            entry.last_visit = time;
+            if(not title.isEmpty())
+                entry.title = title;
+        }
+        return;
+    }
+
+    Entry entry;
+    entry.url = url;
+    entry.title = title;
+    entry.visits = visits;
+    entry.last_visit = time;
+
+    int const id = this->entries.size();
+    this->entries.append(entry);
+    this->keys.append(url.toLower());
+    this->index_by_url.insert(url, id);
+    this->unindexed.append(id);
+}
+
+void GlobalHistory::compact()
+{
+    QSaveFile file { this->log_file };
+    if(not file.open(QFile::WriteOnly)) {
+        qDebug() << "failed to compact" << this->log_file << file.errorString();
+        return;
+    }
+
+    for(auto const & entry : qAsConst(this->store.entries))
+    {
+        file.write(encodeRecord(entry.last_visit, entry.visits, entry.url, entry.title));
+    }
+
+    if(file.commit()) {
+        this->store.log_records = this->store.entries.size();
+    } else {
+        qDebug() << "failed to compact" << this->log_file << file.errorString();
+    }
+}
+
+QStringRef GlobalHistory::Store::keyText(const IndexKey &key) const
+{
+    return this->keys.at(key.entry).midRef(key.offset);
+}
+
+double GlobalHistory::score(const Entry &entry, qint64 now)
+{
+    double const age_in_days = double(now - entry.last_visit) / 86400.0;
+
+    double recency;
+    if(age_in_days < 1)
+        recency = 4.0;
+    else if(age_in_days < 7)
+        recency = 2.0;
+    else if(age_in_days < 30)
+        recency = 1.0;
+    else
+        recency = 0.5;
+
+    return entry.visits * recency;
+}
+
+GlobalHistoryLoader::GlobalHistoryLoader(const QString &file_name, qint64 size) :
+    file_name(file_name),
+    size(size)
+{
+    // The job deletes itself in the thread it was created in,
+    // so it's still alive when its queued signal is delivered
+    this->setAutoDelete(false);
+}
+
+void GlobalHistoryLoader::run()
+{
+    this->store.read(this->file_name, this->size);
+    emit this->finished();
+    this->deleteLater();
+}
@@ -0,0 +1,134 @@
+#ifndef GLOBALHISTORY_HPP
+#define GLOBALHISTORY_HPP
+
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+#include <QHash>
+
+//! Stores every page the user visited across all tabs and sessions.
+//! Visits are appended to a log file, which is read and indexed on a
+//! worker thread at startup. Until it's loaded, only the visits of this
+//! session are known. Completion uses a sorted index of the urls, so
+//! prefix lookups only scan the matching entries.
+class GlobalHistory : public QObject
+{
+    Q_OBJECT
+    friend class GlobalHistoryLoader;
+public:
+    struct Entry
+    {
+        QString url;
+        QString title;
+        int visits = 0;
+        qint64 last_visit = 0; // seconds since epoch
+    };
+
+public:
+    explicit GlobalHistory(QObject *parent = nullptr);
+
+    //! Sets the log file all visits are stored in.
+    void setLogFile(QString const & file_name);
+
+    //! Starts loading the log file in the background.
+    void load();
+
+    //! Returns false while the log file is still loaded.
+    bool isLoaded() const {
+        return this->loaded;
+    }
+
+    //! Records a visit of `url`.
+    void addVisit(QUrl const & url, QString const & title);
+
+    //! Returns the best `limit` entries starting with or containing `text`,
+    //! the best entries first. Prefix matches are preferred.
+    QVector<Entry> complete(QString const & text, int limit);
+
+    //! Returns the `count` most recently visited entries.
+    QVector<Entry> recent(int count);
+
+    //! Removes all entries and the log file.
+    void clear();
+
+    int size();
+
+private:
+    //! A key in the prefix index, the suffix of an entries url starting at `offset`
+    struct IndexKey
+    {
+        int entry;
+        int offset;
+    };
+
+    //! The entries and their index. Built by the loader on its own
+    //! thread and merged with the visits of this session afterwards.
+    struct Store
+    {
+        int log_records = 0;
+
+        QVector<Entry> entries;
+
+        //! Lower case urls of the entries, these are the texts indexed by `prefix_index`
+        QVector<QString> keys;
+
+        QHash<QString, int> index_by_url;
+
+        //! Keys sorted by their text, contains each url with and without scheme
+        QVector<IndexKey> prefix_index;
+
+        //! Entries added since `prefix_index` was last sorted
+        QVector<int> unindexed;
+
+        //! Reads the first `size` bytes of the log `file_name`.
+        void read(QString const & file_name, qint64 size);
+
+        void insert(QString const & url, QString const & title, int visits, qint64 time);
+
+        //! Adds the unindexed entries to the prefix index.
+        void index();
+
+        QStringRef keyText(IndexKey const & key) const;
+    };
+
+private: // slots
+    void on_loaderFinished(Store & store);
+
+private:
+    //! Rewrites the log with one record per entry.
+    void compact();
+
+    static double score(Entry const & entry, qint64 now);
+
+private:
+    QString log_file;
+    bool loading = false;
+    bool loaded = false;
+
+    Store store;
+};
+
+//! Runs on QThreadPool, reads and indexes the log of a GlobalHistory
+class GlobalHistoryLoader : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    GlobalHistoryLoader(QString const & file_name, qint64 size);
+
+    void run() override;
+
+signals:
+    void finished();
+
+public:
+    //! Valid once finished() was emitted
+    GlobalHistory::Store store;
+
+private:
+    QString file_name;
+    qint64 size;
+};
+
+#endif // GLOBALHISTORY_HPP
@@ -0,0 +1,371 @@
+#include "headless.hpp"
+#include "kristall.hpp"
+#include "ioutil.hpp"
+
+#include "renderers/renderhelpers.hpp"
+
+#include "protocols/geminiclient.hpp"
+#include "protocols/webclient.hpp"
+#include "protocols/gopherclient.hpp"
+#include "protocols/fingerclient.hpp"
+#include "protocols/abouthandler.hpp"
+#include "protocols/filehandler.hpp"
+#include "protocols/archivehandler.hpp"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextStream>
+#include <QTimer>
+#include <QDebug>
+
+//! Documents are laid out with this width, like in a typical window
+static const int LAYOUT_WIDTH = 800; // px
+
+HeadlessBrowser::HeadlessBrowser(QObject *parent) : QObject(parent)
+{
+    // Same order as in the tabs, replayed responses take precedence
+    if(kristall::archive.isReplaying())
+        this->protocol_handlers.emplace_back(std::make_unique<ArchiveHandler>());
+
+    this->protocol_handlers.emplace_back(std::make_unique<GeminiClient>());
+    this->protocol_handlers.emplace_back(std::make_unique<FingerClient>());
+    this->protocol_handlers.emplace_back(std::make_unique<GopherClient>());
+    this->protocol_handlers.emplace_back(std::make_unique<WebClient>());
+    this->protocol_handlers.emplace_back(std::make_unique<AboutHandler>());
+    this->protocol_handlers.emplace_back(std::make_unique<FileHandler>());
+}
+
+HeadlessBrowser::~HeadlessBrowser()
+{
+
+}
+
+int HeadlessBrowser::run(const QList<QUrl> &urls, DumpFormat format, bool render_stats)
+{
+    QTextStream out { stdout };
+    out.setCodec("UTF-8");
+
+    bool all_ok = true;
+    for(auto const & url : urls)
+    {
+        Result result = this->load(url, format);
+        if(not result.ok) {
+            qWarning().noquote() << url.toString() << "failed:" << result.error;
+            all_ok = false;
+        }
+
+        if(format != NoDump and not result.dump.isEmpty()) {
+            out << result.dump;
+            if(not result.dump.endsWith('\n'))
+                out << '\n';
+        }
+
+        // One object per line, so multiple urls can be processed as JSON lines
+        if(render_stats) {
+            out << QJsonDocument(statistics(result)).toJson(QJsonDocument::Compact) << '\n';
+        }
+        out.flush();
+    }
+
+    return all_ok ? 0 : 1;
+}
+
+HeadlessBrowser::Result HeadlessBrowser::load(const QUrl &url, DumpFormat format)
+{
+    Result result;
+    result.requested_url = url;
+    result.url = kristall::redirects.resolve(url);
+
+    this->fetch(result);
+    if(result.ok) {
+        this->render(result, format);
+    }
+    return result;
+}
+
+QJsonObject HeadlessBrowser::statistics(const Result &result)
+{
+    QJsonObject timings;
+    for(int i = 0; i < RequestTimings::PhaseCount; i++)
+    {
+        qint64 const time = result.timings.get(RequestTimings::Phase(i));
+        if(time >= 0)
+            timings.insert(RequestTimings::phaseKey(RequestTimings::Phase(i)), double(time));
+    }
+
+    QJsonObject stats {
+        { "url", result.requested_url.toString(QUrl::FullyEncoded) },
+        { "location", result.url.toString(QUrl::FullyEncoded) },
+        { "ok", result.ok },
+        { "redirections", result.redirections },
+        { "from_cache", result.from_cache },
+        { "fetch_ms", double(result.fetch_time) },
+        { "timings", timings },
+    };
+
+    if(not result.ok) {
+        stats.insert("error", result.error);
+        return stats;
+    }
+
+    stats.insert("mime", result.mime.toString());
+    stats.insert("size", result.body.size());
+    stats.insert("render_ms", double(result.render_time));
+    stats.insert("title", result.title);
+    stats.insert("links", result.link_count);
+    stats.insert("blocks", result.block_count);
+    stats.insert("characters", result.character_count);
+    return stats;
+}
+
+void HeadlessBrowser::fetch(Result &result)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    bool const is_internal = (result.url.scheme() == "about") or (result.url.scheme() == "file");
+
+    kristall::cache.clean();
+    if(auto page = kristall::cache.find(result.url); page != nullptr and not is_internal)
+    {
+        result.body = page->body;
+        result.mime = page->mime;
+        result.from_cache = true;
+        result.ok = true;
+        result.fetch_time = clock.elapsed();
+        return;
+    }
+
+    while(true)
+    {
+        ProtocolHandler * handler = this->handlerFor(result.url);
+        if(handler == nullptr) {
+            result.error = QString("Unsupported scheme: %1").arg(result.url.scheme());
+            break;
+        }
+
+        // Don't send anything to a host that asked us to slow down
+        if(qint64 const delay = kristall::rate_limits.remainingTime(result.url.host()); delay > 0) {
+            QEventLoop wait;
+            QTimer::singleShot(int(delay), &wait, &QEventLoop::quit);
+            wait.exec();
+        }
+
+        bool done = false;
+        QUrl redirect_target;
+        QEventLoop loop;
+
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        QObject::connect(&timeout, &QTimer::timeout, &loop, [&]() {
+            handler->cancelRequest();
+            result.error = "The server didn't respond in time.";
+            done = true;
+            loop.quit();
+        });
+
+        auto const finish = [&]() {
+            done = true;
+            timeout.stop();
+            loop.quit();
+        };
+
+        QList<QMetaObject::Connection> connections;
+        connections << connect(handler, &ProtocolHandler::requestComplete, &loop, [&](QByteArray const & data, QString const & mime) {
+            result.body = data;
+            result.mime = MimeParser::parse(mime);
+            result.ok = true;
+            finish();
+        });
+        connections << connect(handler, &ProtocolHandler::redirected, &loop, [&](QUrl const & uri, bool) {
+            redirect_target = result.url.resolved(uri);
+            finish();
+        });
+        connections << connect(handler, &ProtocolHandler::networkError, &loop, [&](ProtocolHandler::NetworkError, QString const & reason) {
+            result.error = reason;
+            finish();
+        });
+        connections << connect(handler, &ProtocolHandler::inputRequired, &loop, [&](QString const & query, bool is_sensitive) {
+            if(is_sensitive)
+                this->sensitive_inputs.insert(result.url.adjusted(QUrl::RemoveQuery | QUrl::RemoveFragment));
+            result.error = QString("The server requires input: %1").arg(query);
+            finish();
+        });
+        connections << connect(handler, &ProtocolHandler::certificateRequired, &loop, [&](QString const & info) {
+            result.error = QString("The server requires a client certificate: %1").arg(info);
+            finish();
+        });
+
+        // Same records as the tabs write, so the session can be replayed in both
+        if(kristall::archive.isRecording())
+        {
+            QUrl const location = result.url;
+            auto const record_response = [this, handler, location](int status, QString const & meta, QByteArray const & body, int error) {
+                if((location.scheme() == "about") or (location.scheme() == "file"))
+                    return;
+                // Like in the tabs, answers to sensitive input aren't written to disk
+                if(location.hasQuery() and this->sensitive_inputs.contains(location.adjusted(QUrl::RemoveQuery | QUrl::RemoveFragment)))
+                    return;
+                NetworkArchive::Entry entry;
+                entry.url = location.adjusted(QUrl::RemoveFragment);
+                entry.status = status;
+                entry.meta = meta;
+                entry.error = error;
+                entry.body = body;
+                entry.timings = handler->timings();
+                kristall::archive.record(entry);
+            };
+            connections << connect(handler, &ProtocolHandler::requestComplete, &loop, [record_response](QByteArray const & data, QString const & mime) {
+                record_response(20, mime, data, 0);
+            });
+            connections << connect(handler, &ProtocolHandler::redirected, &loop, [record_response](QUrl const & uri, bool is_permanent) {
+                record_response(is_permanent ? 31 : 30, uri.toString(QUrl::FullyEncoded), QByteArray { }, 0);
+            });
+            connections << connect(handler, &ProtocolHandler::inputRequired, &loop, [record_response](QString const & query, bool is_sensitive) {
+                record_response(is_sensitive ? 11 : 10, query, QByteArray { }, 0);
+            });
+            connections << connect(handler, &ProtocolHandler::certificateRequired, &loop, [record_response](QString const & info) {
+                record_response(60, info, QByteArray { }, 0);
+            });
+            connections << connect(handler, &ProtocolHandler::networkError, &loop, [record_response](ProtocolHandler::NetworkError error, QString const & reason) {
+                record_response(0, reason, QByteArray { }, int(error));
+            });
+        }
+
+        // Like in the tabs, the timeout restarts whenever the request makes progress
+        auto const restart_timeout = [&]() {
+            if(not done)
+                timeout.start(int(kristall::options.network_timeout));
+        };
+        connections << connect(handler, &ProtocolHandler::requestProgress, &loop, restart_timeout);
+        connections << connect(handler, &ProtocolHandler::requestStateChange, &loop, restart_timeout);
+
+        restart_timeout();
+
+        // Some handlers answer right away, before the loop runs
+        if(not handler->startRequest(result.url.adjusted(QUrl::RemoveFragment), ProtocolHandler::Default)) {
+            if(not done)
+                result.error = QString("Failed to execute request to %1").arg(result.url.toString());
+            done = true;
+        }
+        if(not done) {
+            loop.exec();
+        }
+
+        for(auto const & connection : connections)
+            disconnect(connection);
+
+        result.timings = handler->timings();
+
+        if(redirect_target.isEmpty())
+            break;
+
+        result.redirections += 1;
+        if(result.redirections > kristall::options.max_redirections) {
+            result.error = QString("Too many redirections, the last one was to %1").arg(redirect_target.toString());
+            break;
+        }
+        result.url = redirect_target;
+    }
+
+    result.fetch_time = clock.elapsed();
+
+    // Text documents are cached like in the tabs
+    if(result.ok and result.mime.is("text") and not is_internal) {
+        kristall::cache.push(result.url, result.body, result.mime);
+    }
+}
+
+void HeadlessBrowser::render(Result &result, DumpFormat format)
+{
+    MimeType const & mime = result.mime;
+    if(not mime.is("text"))
+        return;
+
+    QByteArray data = result.body;
+
+    auto charset = mime.parameter("charset", "utf-8").toUpper();
+    if(not data.isEmpty() and not IoUtil::isUtf8Compatible(charset))
+    {
+        auto converted = IoUtil::convertToUtf8(data, charset);
+        if(converted.isEmpty()) {
+            qWarning() << "failed to convert charset" << charset << "to UTF-8, rendering unconverted data";
+        } else {
+            data = std::move(converted);
+        }
+    }
+
+    QElapsedTimer render_timer;
+    render_timer.start();
+
+    auto doc_style = kristall::document_style.derive(result.url);
+    DocumentOutlineModel outline;
+    std::unique_ptr<QTextDocument> document = renderhelpers::renderDocument(data, mime, result.url, doc_style, outline, result.title);
+
+    // The tabs lay the document out when it's shown
+    document->setTextWidth(LAYOUT_WIDTH);
+    document->size();
+
+    result.render_time = render_timer.elapsed();
+
+    result.block_count = document->blockCount();
+    result.character_count = document->characterCount();
+    for(QTextBlock block = document->begin(); block.isValid(); block = block.next())
+    {
+        for(auto it = block.begin(); not it.atEnd(); ++it)
+        {
+            if(not it.fragment().charFormat().anchorHref().isEmpty())
+                result.link_count += 1;
+        }
+    }
+
+    switch(format)
+    {
+    case NoDump:
+        break;
+    case PlainText:
+        result.dump = document->toPlainText();
+        break;
+    case Gemtext:
+        if(mime.is("text", "gemini"))
+            result.dump = QString::fromUtf8(data);
+        else
+            result.dump = toGemtext(*document);
+        break;
+    }
+}
+
+ProtocolHandler *HeadlessBrowser::handlerFor(const QUrl &url) const
+{
+    for(auto const & handler : this->protocol_handlers)
+    {
+        if(handler->supportsScheme(url.scheme()))
+            return handler.get();
+    }
+    return nullptr;
+}
+
+QString HeadlessBrowser::toGemtext(const QTextDocument &document)
+{
+    QString gemtext;
+    for(QTextBlock block = document.begin(); block.isValid(); block = block.next())
+    {
+        QString href;
+        for(auto it = block.begin(); not it.atEnd() and href.isEmpty(); ++it)
+            href = it.fragment().charFormat().anchorHref();
+
+        QString const text = block.text().trimmed();
+        if(href.isEmpty()) {
+            gemtext += block.text().replace(QChar::LineSeparator, '\n');
+        } else if(text.isEmpty()) {
+            gemtext += "=> " + href;
+        } else {
+            gemtext += "=> " + href + " " + text;
+        }
+        gemtext += '\n';
+    }
+    return gemtext;
+}
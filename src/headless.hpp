@@ -0,0 +1,87 @@
+#ifndef HEADLESS_HPP
+#define HEADLESS_HPP
+
+#include <QObject>
+#include <QJsonObject>
+#include <QSet>
+#include <QUrl>
+
+#include <memory>
+#include <vector>
+
+#include "mimeparser.hpp"
+#include "protocolhandler.hpp"
+
+class QTextDocument;
+
+//! Fetches and renders pages without a window, used by `--headless`.
+//! Requests go through the same protocol handlers, trust store, redirect
+//! cache and page cache as the tabs and are rendered with the normal renderers.
+class HeadlessBrowser : public QObject
+{
+    Q_OBJECT
+public:
+    enum DumpFormat {
+        NoDump,
+        PlainText, //!< The rendered document as plain text
+        Gemtext,   //!< Gemini documents as received, other documents converted to gemtext
+    };
+
+    struct Result
+    {
+        QUrl requested_url;
+        QUrl url; //!< Location after following redirections
+
+        bool ok = false;
+        QString error;
+
+        MimeType mime;
+        QByteArray body;
+        bool from_cache = false;
+        int redirections = 0;
+        RequestTimings timings;
+
+        qint64 fetch_time = -1; // ms
+        qint64 render_time = -1; // ms, including the layout
+
+        QString title;
+        int link_count = 0;
+        int block_count = 0;
+        int character_count = 0;
+
+        QString dump;
+    };
+
+public:
+    explicit HeadlessBrowser(QObject * parent = nullptr);
+    ~HeadlessBrowser() override;
+
+    //! Loads all `urls` one after another and writes the dumps and
+    //! statistics to stdout. Returns the exit code of the application.
+    int run(QList<QUrl> const & urls, DumpFormat format, bool render_stats);
+
+    //! Fetches and renders `url`, blocking until both are done.
+    Result load(QUrl const & url, DumpFormat format);
+
+    //! Returns the statistics of `result` as printed by `--render-stats`.
+    static QJsonObject statistics(Result const & result);
+
+private:
+    void fetch(Result & result);
+
+    void render(Result & result, DumpFormat format);
+
+    ProtocolHandler * handlerFor(QUrl const & url) const;
+
+    //! Writes the blocks of `document` as gemtext, blocks containing a link become link lines.
+    static QString toGemtext(QTextDocument const & document);
+
+private:
+    std::vector<std::unique_ptr<ProtocolHandler>> protocol_handlers;
+
+    //! Locations that asked for sensitive input. Requests to them with a
+    //! query carry the answer, so they aren't recorded.
+    QSet<QUrl> sensitive_inputs;
+};
+
+#endif // HEADLESS_HPP
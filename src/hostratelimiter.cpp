@@ -0,0 +1,51 @@
+#include "hostratelimiter.hpp"
+
+#include <QDebug>
+
+void HostRateLimiter::throttle(const QString &host, int seconds)
+{
+    this->removeExpired();
+
+    seconds = qBound(0, seconds, max_delay);
+
+    QDeadlineTimer deadline { qint64(seconds) * 1000 };
+
+    // Never shorten a delay the host requested earlier
+    if(auto it = this->deadlines.find(host); it != this->deadlines.end())
+    {
+        if(it->remainingTime() >= deadline.remainingTime())
+            return;
+    }
+
+    qDebug() << "rate limit: throttling" << host << "for" << seconds << "seconds";
+    this->deadlines.insert(host, deadline);
+}
+
+bool HostRateLimiter::isThrottled(const QString &host) const
+{
+    return (this->remainingTime(host) > 0);
+}
+
+qint64 HostRateLimiter::remainingTime(const QString &host) const
+{
+    auto it = this->deadlines.find(host);
+    if(it == this->deadlines.end())
+        return 0;
+    return it->remainingTime();
+}
+
+void HostRateLimiter::clear()
+{
+    this->deadlines.clear();
+}
+
+void HostRateLimiter::removeExpired()
+{
+    for(auto it = this->deadlines.begin(); it != this->deadlines.end(); )
+    {
+        if(it->hasExpired())
+            it = this->deadlines.erase(it);
+        else
+            ++it;
+    }
+}
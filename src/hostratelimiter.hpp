@@ -0,0 +1,35 @@
+#ifndef HOSTRATELIMITER_HPP
+#define HOSTRATELIMITER_HPP
+
+#include <QHash>
+#include <QString>
+#include <QDeadlineTimer>
+
+//! Keeps track of hosts that asked us to slow down (gemini status 44)
+//! and for how long we should not send any more requests to them.
+class HostRateLimiter
+{
+public:
+    //! Longest delay we accept from a server, in seconds.
+    static constexpr int max_delay = 3600;
+
+public:
+    //! Records that `host` doesn't want any requests for the next `seconds` seconds.
+    void throttle(QString const & host, int seconds);
+
+    //! Returns true if requests to `host` should be held back.
+    bool isThrottled(QString const & host) const;
+
+    //! Returns the remaining time in milliseconds until `host` accepts requests again.
+    qint64 remainingTime(QString const & host) const;
+
+    void clear();
+
+private:
+    void removeExpired();
+
+private:
+    QHash<QString, QDeadlineTimer> deadlines;
+};
+
+#endif // HOSTRATELIMITER_HPP
@@ -4,6 +4,7 @@
 #include <QDebug>
 #include <QIcon>
 #include <QMimeData>
+#include <QUrl>
 
 #include <memory>
 
@@ -13,6 +14,8 @@ IdentityCollection::IdentityCollection(QObject *parent)
 
 }
 
+// Copying the identities only copies the user information,
+// the key material is shared between the collections.
 IdentityCollection::IdentityCollection(const IdentityCollection &other)
 {
     for(auto const & grp : other.root.children)
@@ -103,15 +106,11 @@ void IdentityCollection::load(QSettings &settings)
             id->identity.host_filter = settings.value("host_filter", "").toString();
             id->identity.auto_enable = settings.value("auto_enable", false).toBool();
 
-            id->identity.certificate = QSslCertificate::fromData(
+            // Parsing keys is expensive, so they are only decoded when the identity is used
+            id->identity.setEncoded(
                 settings.value("certificate").toByteArray(),
-                QSsl::Der
-            ).constFirst();
-
-            id->identity.private_key = QSslKey(
                 settings.value("private_key").toByteArray(),
-                QSsl::Rsa,
-                QSsl::Der
+                QSsl::Rsa
             );
 
             group->children.emplace_back(std::move(id));
@@ -153,8 +152,8 @@ void IdentityCollection::save(QSettings &settings) const
 
             settings.setValue("display_name",  id.identity.display_name);
             settings.setValue("user_notes",  id.identity.user_notes);
-            settings.setValue("certificate", id.identity.certificate.toDer());
-            settings.setValue("private_key", id.identity.private_key.toDer());
+            settings.setValue("certificate", id.identity.certificateDer());
+            settings.setValue("private_key", id.identity.privateKeyDer());
 
             settings.setValue("host_filter", id.identity.host_filter);
             settings.setValue("auto_enable", id.identity.auto_enable);
@@ -217,6 +216,9 @@ CryptoIdentity * IdentityCollection::getMutableIdentity(const QModelIndex &index
     if (!index.isValid())
         return nullptr;
 
+    // The caller may change the host filter
+    this->host_index_dirty = true;
+
     if (index.column() != 0)
         return nullptr;
 
@@ -267,6 +269,7 @@ bool IdentityCollection::destroyIdentity(const QModelIndex &index)
     beginRemoveRows(this->parent(index), index.row(), index.row() + 1);
 
     parent->children.erase(parent->children.begin() + childItem->index);
+    this->relayout();
 
     endRemoveRows();
 
@@ -300,6 +303,7 @@ bool IdentityCollection::deleteGroup(const QString &group_name)
             beginRemoveRows(QModelIndex { }, index, index + 1);
 
             root.children.erase(it);
+            this->relayout();
 
             endRemoveRows();
 
@@ -324,6 +328,84 @@ QVector<const CryptoIdentity *> IdentityCollection::allIdentities() const
     return identities;
 }
 
+//! Returns the literal host of a host filter like `gemini://example.com/*`
+//! or an empty string if the host contains wildcards.
+static QString literalFilterHost(QString const & filter)
+{
+    int start = filter.indexOf("://");
+    if(start < 0)
+        return QString { };
+    start += 3;
+
+    int end = start;
+    while(end < filter.size() and filter[end] != '/' and filter[end] != ':')
+        end += 1;
+
+    QString host = filter.mid(start, end - start);
+    for(QChar c : host) {
+        if(c == '*' or c == '?' or c == '[' or c == '@')
+            return QString { };
+    }
+    return host.toLower();
+}
+
+CryptoIdentity const * IdentityCollection::automaticIdentityFor(const QUrl &url) const
+{
+    if(this->host_index_dirty)
+        this->rebuildHostIndex();
+
+    static QVector<AutoEnableEntry> const no_entries;
+
+    auto it = this->host_index.constFind(url.host(QUrl::FullyEncoded).toLower());
+    auto const & by_host = (it != this->host_index.constEnd()) ? *it : no_entries;
+    auto const & wildcards = this->wildcard_hosts;
+
+    // Both lists are sorted by order, so merging them
+    // finds the first matching identity in the collection
+    int i = 0, j = 0;
+    while(i < by_host.size() or j < wildcards.size())
+    {
+        AutoEnableEntry const * entry;
+        if(j >= wildcards.size() or (i < by_host.size() and by_host[i].order < wildcards[j].order))
+            entry = &by_host[i++];
+        else
+            entry = &wildcards[j++];
+
+        if(entry->identity->isAutomaticallyEnabledOn(url))
+            return entry->identity;
+    }
+    return nullptr;
+}
+
+void IdentityCollection::rebuildHostIndex() const
+{
+    this->host_index.clear();
+    this->wildcard_hosts.clear();
+
+    int order = 0;
+    for(auto const & group : this->root.children)
+    {
+        for(auto const & ident : group->children)
+        {
+            auto const & identity = ident->as<IdentityNode>().identity;
+            if(identity.host_filter.isEmpty() or not identity.auto_enable)
+                continue;
+
+            // Compile the pattern now instead of during navigation
+            identity.hostPattern();
+
+            AutoEnableEntry entry { order++, &identity };
+            QString host = literalFilterHost(identity.host_filter);
+            if(host.isEmpty())
+                this->wildcard_hosts.append(entry);
+            else
+                this->host_index[host].append(entry);
+        }
+    }
+
+    this->host_index_dirty = false;
+}
+
 QModelIndex IdentityCollection::index(int row, int column, const QModelIndex &parent) const
 {
     if (not hasIndex(row, column, parent))
@@ -457,9 +539,9 @@ QMimeData *IdentityCollection::mimeData(const QModelIndexList &indexes) const
             stream << identity.user_notes;
             stream << identity.host_filter;
             stream << identity.auto_enable;
-            stream << identity.certificate.toDer();
-            stream << int(identity.private_key.algorithm());
-            stream << identity.private_key.toDer();
+            stream << identity.certificateDer();
+            stream << int(identity.keyAlgorithm());
+            stream << identity.privateKeyDer();
         }
         assert(buffer.size() > 0);
 
@@ -523,8 +605,7 @@ bool IdentityCollection::dropMimeData(const QMimeData *data, Qt::DropAction acti
             stream >> key_algorithm;
             stream >> key_data;
 
-            identity.certificate = QSslCertificate { cert_data, QSsl::Der };
-            identity.private_key = QSslKey { key_data, QSsl::KeyAlgorithm(key_algorithm), QSsl::Der, QSsl::PrivateKey };
+            identity.setEncoded(cert_data, key_data, QSsl::KeyAlgorithm(key_algorithm));
         }
 
         if(not identity.isValid())
@@ -579,6 +660,7 @@ bool IdentityCollection::removeRows(int row, int count, const QModelIndex &paren
 
         beginRemoveRows(parent, row, row + 1);
         children.erase(children.begin() + size_t(row));
+        this->relayout();
         endRemoveRows();
 
         return true;
@@ -590,6 +672,9 @@ bool IdentityCollection::removeRows(int row, int count, const QModelIndex &paren
 
 void IdentityCollection::relayout()
 {
+    this->host_index_dirty = true;
+    this->identity_count = 0;
+
     for(size_t i = 0; i < root.children.size(); i++)
     {
         auto & group = *root.children[i];
@@ -604,6 +689,7 @@ void IdentityCollection::relayout()
             id.parent = &group;
             id.index = j;
             assert(id.children.size() == 0);
+            this->identity_count += 1;
 
             // qDebug() << "id[" << id.index << "]" << id.as<IdentityNode>().identity.display_name;
         }
@@ -6,6 +6,8 @@
 #include <QAbstractItemModel>
 #include <memory>
 #include <QSettings>
+#include <QHash>
+#include <QVector>
 
 class IdentityCollection : public QAbstractItemModel
 {
@@ -77,6 +79,16 @@ public:
     //! Returns a list of non-mutable references to all contained identities
     QVector<CryptoIdentity const *> allIdentities() const;
 
+    //! Returns the first identity that should be automatically enabled on `url`
+    //! or `nullptr` if there is none. The host filters are indexed by their
+    //! host, so only filters that can match the host of `url` are evaluated.
+    CryptoIdentity const * automaticIdentityFor(QUrl const & url) const;
+
+    //! Returns the number of identities in all groups.
+    int identityCount() const {
+        return this->identity_count;
+    }
+
 public:
     // Header:
     // QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -111,8 +123,29 @@ private:
 
     bool internalAddGroup(QString const & group_name, GroupNode * & out_group);
 
+    void rebuildHostIndex() const;
+
 private:
     RootNode root;
+
+    //! An identity that is automatically enabled, `order` is its position
+    //! in the collection, which decides between multiple matches.
+    struct AutoEnableEntry {
+        int order;
+        CryptoIdentity const * identity;
+    };
+
+    //! Counted in relayout(), which runs after every structural change
+    int identity_count = 0;
+
+    //! Set whenever identities are added, removed or may have been modified.
+    mutable bool host_index_dirty = true;
+
+    //! Identities with a literal host in their filter, keyed by that host
+    mutable QHash<QString, QVector<AutoEnableEntry>> host_index;
+
+    //! Identities with a wildcard host, these have to be checked for every url
+    mutable QVector<AutoEnableEntry> wildcard_hosts;
 };
 
 #endif // IDENTITYCOLLECTION_HPP
@@ -1,5 +1,9 @@
 #include "ioutil.hpp"
 
+#include <iconv.h>
+#include <cerrno>
+#include <cstdio>
+
 bool IoUtil::writeAll(QIODevice &dst, QByteArray const & src)
 {
     qint64 offset = 0;
@@ -49,3 +53,75 @@ QString IoUtil::uniformUrlString(QUrl url)
 {
     return IoUtil::uniformUrl(url).toString(QUrl::FullyEncoded);
 }
+
+bool IoUtil::isUtf8Compatible(const QString &charSet)
+{
+    QString const charset = charSet.toUpper();
+    return (charset == "UTF-8") or (charset == "UTF8") or (charset == "US-ASCII") or (charset == "ASCII");
+}
+
+QByteArray IoUtil::convertToUtf8(QByteArray const & input, QString const & charSet)
+{
+    auto charset_u8 = charSet.toUpper().toUtf8();
+
+    // TRANSLIT will try to mix-match other code points to reflect to correct encoding
+    iconv_t cd = iconv_open("UTF-8", charset_u8.data());
+    if(cd == (iconv_t)-1) {
+        return QByteArray { };
+    }
+
+    QByteArray result;
+    result.reserve(input.size());
+
+    char temp_buffer[4096];
+
+#if defined(__NetBSD__)
+    char const * input_ptr = reinterpret_cast<char const *>(input.data());
+#else
+    char * input_ptr = const_cast<char *>(reinterpret_cast<char const *>(input.data()));
+#endif
+    size_t input_size = input.size();
+
+    while(input_size > 0)
+    {
+        char * out_ptr = temp_buffer;
+        size_t out_size = sizeof(temp_buffer);
+
+        size_t n = iconv(cd, &input_ptr, &input_size, &out_ptr, &out_size);
+        if (n == size_t(-1))
+        {
+            if(errno == E2BIG) {
+                // silently ignore E2BIG, as we will continue conversion in the next loop
+            }
+            else if(errno == EILSEQ) {
+                // this is an invalid multibyte sequence.
+                // append an "replacement character" and skip a byte
+                if(input_size > 0) {
+                    input_size --;
+                    input_ptr++;
+                    result.append(u8"�");
+                }
+            }
+            else if(errno == EINVAL) {
+                // the file ends with an invalid multibyte sequence.
+                // just drop it and display the replacement-character
+                if(input_size > 0) {
+                    input_size --;
+                    input_ptr++;
+                    result.append(u8"�");
+                }
+            }
+            else {
+                perror("iconv conversion error");
+                break;
+            }
+        }
+
+        size_t len = out_ptr - temp_buffer;
+        result.append(temp_buffer, len);
+    }
+
+    iconv_close(cd);
+
+    return result;
+}
@@ -12,6 +12,13 @@ struct IoUtil
 
     static QUrl uniformUrl(QUrl url);
     static QString uniformUrlString(QUrl url);
+
+    //! Returns true if text in `charSet` is already valid UTF-8, like US-ASCII.
+    static bool isUtf8Compatible(QString const & charSet);
+
+    //! Converts `input` from `charSet` to UTF-8. Invalid sequences are replaced,
+    //! returns an empty array if the charset is unknown.
+    static QByteArray convertToUtf8(QByteArray const & input, QString const & charSet);
 };
 
 #endif // IOUTIL_HPP
@@ -12,6 +12,18 @@
 #include "protocolsetup.hpp"
 #include "documentstyle.hpp"
 #include "cachehandler.hpp"
+#include "requestcoalescer.hpp"
+#include "hostratelimiter.hpp"
+#include "redirectcache.hpp"
+#include "rttestimator.hpp"
+#include "requesttimings.hpp"
+#include "memorygovernor.hpp"
+#include "startuptrace.hpp"
+#include "globalhistory.hpp"
+#include "searchindex.hpp"
+#include "tracing.hpp"
+#include "perfstats.hpp"
+#include "networkarchive.hpp"
 
 enum class Theme : int
 {
@@ -32,6 +44,8 @@ enum class RequestState : int
     Started = 1,
     HostFound = 2,
     Connected = 3,
+    Throttled = 4,
+    Encrypted = 5,
 
     StartedWeb = 255,
 };
@@ -93,6 +107,19 @@ struct GenericSettings
     int cache_life = 60;
     bool cache_unlimited_life = true;
 
+    // Background tabs release their rendered document after
+    // this many minutes without being shown. 0 disables hibernation.
+    int tab_hibernation_timeout = 30;
+
+    // Resident memory kristall tries to stay below, in MiB. 0 disables the limit.
+    int memory_budget = 1024;
+
+    // Maximum number of pages in the full-text search index. 0 disables the limit.
+    int search_index_limit = 250000;
+
+    // Open the tabs of the last session on startup
+    bool restore_session = false;
+
     void load(QSettings & settings);
     void save(QSettings & settings) const;
 };
@@ -126,9 +153,39 @@ namespace kristall
 
     extern CacheHandler cache;
 
+    extern RequestCoalescer coalescer;
+
+    extern HostRateLimiter rate_limits;
+
+    extern RedirectCache redirects;
+
+    extern RttEstimator rtt;
+
+    extern RequestTimingLog timing_log;
+
+    extern MemoryGovernor memory;
+
+    extern StartupTrace startup;
+
+    extern GlobalHistory global_history;
+
+    extern SearchIndex search_index;
+
+    extern TraceRecorder tracer;
+
+    extern PerfStats perf;
+
+    extern NetworkArchive archive;
+
     namespace trust {
         extern SslTrust gemini;
         extern SslTrust https;
+
+        //! Loads the trust stores on first use. Must be called before
+        //! `gemini` or `https` are accessed.
+        void ensureLoaded();
+
+        bool isLoaded();
     }
 
     namespace dirs {
@@ -155,6 +212,15 @@ namespace kristall
 
     void saveWindowState();
 
+    //! Loads the client identities on first use. Must be called
+    //! before `identities` is accessed.
+    void ensureIdentitiesLoaded();
+
+    bool identitiesLoaded();
+
+    //! Registers the built-in emoji fonts when the first emoji is displayed.
+    void ensureEmojiFonts();
+
     extern QString default_font_family, default_font_family_fixed;
 
     //! Whether emojis are supprted in current build configuration
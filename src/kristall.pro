@@ -83,6 +83,12 @@ external-cmark {
     include($$PWD/../lib/cmark/cmark.pri)
 }
 
+# Build with `qmake CONFIG+=tracing` to compile in the trace spans,
+# which can then be recorded with --trace or the View menu.
+tracing {
+    DEFINES += KRISTALL_TRACING
+}
+
 INCLUDEPATH += $$PWD/../lib/luis-l-gist/
 DEPENDPATH += $$PWD/../lib/luis-l-gist/
 
@@ -113,6 +119,7 @@ SOURCES += \
     mimeparser.cpp \
     protocolhandler.cpp \
     protocols/abouthandler.cpp \
+    protocols/archivehandler.cpp \
     protocols/filehandler.cpp \
     protocols/fingerclient.cpp \
     protocols/geminiclient.cpp \
@@ -132,6 +139,21 @@ SOURCES += \
     widgets/favouritepopup.cpp \
     widgets/favouritebutton.cpp \
     cachehandler.cpp \
+    requestcoalescer.cpp \
+    hostratelimiter.cpp \
+    redirectcache.cpp \
+    rttestimator.cpp \
+    requesttimings.cpp \
+    memorygovernor.cpp \
+    startuptrace.cpp \
+    singleinstance.cpp \
+    globalhistory.cpp \
+    searchindex.cpp \
+    pagesearch.cpp \
+    tracing.cpp \
+    perfstats.cpp \
+    networkarchive.cpp \
+    headless.cpp \
     widgets/searchbox.cpp
 
 HEADERS += \
@@ -160,6 +182,7 @@ HEADERS += \
     mimeparser.hpp \
     protocolhandler.hpp \
     protocols/abouthandler.hpp \
+    protocols/archivehandler.hpp \
     protocols/filehandler.hpp \
     protocols/fingerclient.hpp \
     protocols/geminiclient.hpp \
@@ -179,6 +202,21 @@ HEADERS += \
     widgets/favouritepopup.hpp \
     widgets/favouritebutton.hpp \
     cachehandler.hpp \
+    requestcoalescer.hpp \
+    hostratelimiter.hpp \
+    redirectcache.hpp \
+    rttestimator.hpp \
+    requesttimings.hpp \
+    memorygovernor.hpp \
+    startuptrace.hpp \
+    singleinstance.hpp \
+    globalhistory.hpp \
+    searchindex.hpp \
+    pagesearch.hpp \
+    tracing.hpp \
+    perfstats.hpp \
+    networkarchive.hpp \
+    headless.hpp \
     widgets/searchbox.hpp
 
 FORMS += \
@@ -1,5 +1,7 @@
 #include "mainwindow.hpp"
 #include "kristall.hpp"
+#include "singleinstance.hpp"
+#include "headless.hpp"
 
 #include <QApplication>
 #include <QUrl>
@@ -8,6 +10,7 @@
 #include <QDebug>
 #include <QStandardPaths>
 #include <QFontDatabase>
+#include <QFile>
 #include <cassert>
 
 ProtocolSetup       kristall::protocols;
@@ -20,6 +23,18 @@ FavouriteCollection kristall::favourites;
 GenericSettings     kristall::options;
 DocumentStyle       kristall::document_style(false);
 CacheHandler        kristall::cache;
+RequestCoalescer    kristall::coalescer;
+HostRateLimiter     kristall::rate_limits;
+RedirectCache       kristall::redirects;
+RttEstimator        kristall::rtt;
+RequestTimingLog    kristall::timing_log;
+MemoryGovernor      kristall::memory;
+StartupTrace        kristall::startup;
+GlobalHistory       kristall::global_history;
+SearchIndex         kristall::search_index;
+TraceRecorder       kristall::tracer;
+PerfStats           kristall::perf;
+NetworkArchive      kristall::archive;
 QString             kristall::default_font_family;
 QString             kristall::default_font_family_fixed;
 
@@ -47,6 +62,8 @@ static QSettings * app_settings_ptr;
 static QApplication * app;
 static MainWindow * main_window = nullptr;
 static bool closing_state_saved = false;
+static bool identities_loaded = false;
+static bool trust_loaded = false;
 
 #define SSTR(X) STR(X)
 #define STR(X) #X
@@ -65,45 +82,125 @@ static QDir derive_dir(QDir const & parent, QString const & subdir)
     return child;
 }
 
-static void addEmojiSubstitutions()
+void kristall::ensureEmojiFonts()
 {
-    QFontDatabase db;
-
-    auto const families = db.families();
+    static bool loaded = false;
+    if(loaded)
+        return;
+    loaded = true;
 
     // Provide OpenMoji font for a safe fallback
     QFontDatabase::addApplicationFont(":/fonts/OpenMoji-Color.ttf");
     QFontDatabase::addApplicationFont(":/fonts/NotoColorEmoji.ttf");
 
-    QStringList emojiFonts = {
-        // Use system fonts on windows/mac
-        "Apple Color Emoji",
-        "Segoe UI Emoji",
+    qDebug() << "loaded emoji fonts";
+}
 
-        // Provide common fonts as a fallback:
-        // "Noto Color Emoji", // this font seems to replace a lot of text characters?
-        // "JoyPixels", // this font seems to replace a lot of text characters?
+void kristall::ensureIdentitiesLoaded()
+{
+    if(identities_loaded)
+        return;
+    identities_loaded = true;
 
-        // Built-in font fallback
-        "OpenMoji",
-    };
+    KRISTALL_TRACE("load identities", "settings");
 
-    for(auto const & family: families)
-    {
-        auto current = QFont::substitutes(family);
-        current << emojiFonts;
-        // TODO: QFont::insertSubstitutions(family, current);
+    assert(app_settings_ptr != nullptr);
+    app_settings_ptr->beginGroup("Client Identities");
+    kristall::identities.load(*app_settings_ptr);
+    app_settings_ptr->endGroup();
+}
+
+bool kristall::identitiesLoaded()
+{
+    return identities_loaded;
+}
+
+void kristall::trust::ensureLoaded()
+{
+    if(trust_loaded)
+        return;
+    trust_loaded = true;
+
+    KRISTALL_TRACE("load trust stores", "settings");
+
+    assert(app_settings_ptr != nullptr);
+    app_settings_ptr->beginGroup("Trusted Servers");
+    kristall::trust::gemini.load(*app_settings_ptr, kristall::dirs::config_root.absoluteFilePath("trusted-gemini-hosts.journal"));
+    app_settings_ptr->endGroup();
+
+    app_settings_ptr->beginGroup("Trusted HTTPS Servers");
+    kristall::trust::https.load(*app_settings_ptr, kristall::dirs::config_root.absoluteFilePath("trusted-https-hosts.journal"));
+    app_settings_ptr->endGroup();
+}
+
+bool kristall::trust::isLoaded()
+{
+    return trust_loaded;
+}
+
+//! Converts a command line argument into an url. Relative arguments are
+//! either local files or gemini urls without scheme.
+static QUrl urlFromArgument(QString const & arg)
+{
+    QUrl url { arg };
+    if (url.isRelative()) {
+        if (QFile::exists(arg)) {
+            url = QUrl::fromLocalFile(QFileInfo(arg).absoluteFilePath());
+        } else {
+            url = QUrl("gemini://" + arg);
+        }
     }
+    return url;
 }
 
+//! Opens the urls another invocation forwarded to this instance
+static void openForwardedUrls(MainWindow & w, QList<QUrl> const & urls)
+{
+    if(urls.isEmpty()) {
+        w.addEmptyTab(true, true);
+    }
+    for(int i = 0; i < urls.size(); i++) {
+        w.addNewTab(i == 0, urls.at(i));
+    }
+    if(w.isMinimized()) {
+        w.showNormal();
+    }
+    w.raise();
+    w.activateWindow();
+}
+
+#ifdef KRISTALL_TRACING
+static void writeTrace(QString const & trace_file)
+{
+    QFile file { trace_file };
+    if(file.open(QFile::WriteOnly) and kristall::tracer.exportJson(file)) {
+        qDebug() << "Wrote" << kristall::tracer.recordedCount() << "trace events to" << trace_file;
+    } else {
+        qDebug() << "Failed to write trace to" << trace_file << file.errorString();
+    }
+}
+#endif
 
 int main(int argc, char *argv[])
 {
+    kristall::startup.start();
+
+    // Headless runs must work without a display, the platform
+    // has to be chosen before the application is created.
+    for(int i = 1; i < argc; i++)
+    {
+        if((qstrcmp(argv[i], "--headless") == 0) and not qEnvironmentVariableIsSet("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
+
     QApplication app(argc, argv);
     app.setApplicationVersion(SSTR(KRISTALL_VERSION));
 
     ::app = &app;
 
+    kristall::startup.mark("application");
+
     {
         // Initialise default fonts
     #ifdef Q_OS_WIN32
@@ -120,21 +217,179 @@ int main(int argc, char *argv[])
 
     kristall::clipboard = app.clipboard();
 
-    addEmojiSubstitutions();
+    kristall::startup.mark("fonts");
 
     QCommandLineParser cli_parser;
     cli_parser.addVersionOption();
     cli_parser.addHelpOption();
     cli_parser.addPositionalArgument("urls", app.tr("The urls that should be opened instead of the start page"), "[urls...]");
 
+    QCommandLineOption new_instance_option {
+        "new-instance",
+        app.tr("Start a new instance instead of opening the urls in the running one"),
+    };
+    cli_parser.addOption(new_instance_option);
+
+#ifdef KRISTALL_TRACING
+    QCommandLineOption trace_option {
+        "trace",
+        app.tr("Record a performance trace and write it to <file> on exit, in the Chrome trace event format"),
+        "file",
+    };
+    cli_parser.addOption(trace_option);
+#endif
+
+    QCommandLineOption record_option {
+        "record",
+        app.tr("Record all network responses into the archive <file>"),
+        "file",
+    };
+    cli_parser.addOption(record_option);
+
+    QCommandLineOption replay_option {
+        "replay",
+        app.tr("Serve all network requests from the archive <file> instead of the network"),
+        "file",
+    };
+    cli_parser.addOption(replay_option);
+
+    QCommandLineOption replay_scale_option {
+        "replay-scale",
+        app.tr("Multiply the recorded timings with <factor> when replaying, 0 replays without delays"),
+        "factor",
+        "1",
+    };
+    cli_parser.addOption(replay_scale_option);
+
+    QCommandLineOption headless_option {
+        "headless",
+        app.tr("Fetch and render the urls without opening a window"),
+    };
+    cli_parser.addOption(headless_option);
+
+    QCommandLineOption dump_option {
+        "dump",
+        app.tr("Write the rendered documents to stdout, used with --headless"),
+    };
+    cli_parser.addOption(dump_option);
+
+    QCommandLineOption dump_format_option {
+        "dump-format",
+        app.tr("Format of --dump, either \"text\" or \"gemtext\""),
+        "format",
+        "text",
+    };
+    cli_parser.addOption(dump_format_option);
+
+    QCommandLineOption render_stats_option {
+        "render-stats",
+        app.tr("Write timings, sizes and link counts of the documents as JSON to stdout, used with --headless"),
+    };
+    cli_parser.addOption(render_stats_option);
+
     cli_parser.process(app);
 
+#ifdef KRISTALL_TRACING
+    QString const trace_file = cli_parser.value(trace_option);
+    if(not trace_file.isEmpty()) {
+        kristall::tracer.setEnabled(true);
+    }
+#endif
+
+    QString const record_file = cli_parser.value(record_option);
+    if(not record_file.isEmpty() and not kristall::archive.startRecording(record_file)) {
+        qWarning() << "Failed to open the archive" << record_file;
+        return 1;
+    }
+
+    QString const replay_file = cli_parser.value(replay_option);
+    if(not replay_file.isEmpty()) {
+        if(not kristall::archive.startReplay(replay_file)) {
+            qWarning() << "Failed to load the archive" << replay_file;
+            return 1;
+        }
+        kristall::archive.setReplayScale(cli_parser.value(replay_scale_option).toDouble());
+    }
+
+    QList<QUrl> urls;
+    for(const auto &url_str : cli_parser.positionalArguments()) {
+        QUrl url = urlFromArgument(url_str);
+        if(url.isValid()) {
+            urls.append(url);
+        } else {
+            qDebug() << "Invalid url: " << url_str;
+        }
+    }
+
+    bool const headless = cli_parser.isSet(headless_option);
+    bool const render_stats = cli_parser.isSet(render_stats_option);
+
+    HeadlessBrowser::DumpFormat dump_format = HeadlessBrowser::NoDump;
+    if(cli_parser.isSet(dump_option) or not render_stats) {
+        QString const format = cli_parser.value(dump_format_option);
+        if(format == "text") {
+            dump_format = HeadlessBrowser::PlainText;
+        } else if(format == "gemtext") {
+            dump_format = HeadlessBrowser::Gemtext;
+        } else {
+            qWarning() << "Unknown dump format" << format;
+            return 1;
+        }
+    }
+
+    if(headless and urls.isEmpty()) {
+        qWarning() << "--headless needs at least one url";
+        return 1;
+    }
+
     QString cache_root = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
     QString config_root = QStandardPaths::writableLocation(QStandardPaths::AppConfigLocation);
 
     kristall::dirs::config_root = QDir { config_root };
     kristall::dirs::cache_root  = QDir { cache_root };
 
+    // Instances sharing a configuration would overwrite each others settings,
+    // so the urls are opened by the running instance if there is one.
+    // Headless, recorded and replayed sessions must not end up in another instance.
+    bool const single_instance = not cli_parser.isSet(new_instance_option)
+        and not headless
+        and not kristall::archive.isRecording()
+        and not kristall::archive.isReplaying();
+    SingleInstance instance { config_root };
+    bool window_ready = false;
+    QList<QList<QUrl>> pending_forwards;
+    if(single_instance)
+    {
+        switch(instance.forward(urls))
+        {
+        case SingleInstance::Forwarded:
+            qDebug() << "Opened" << urls.size() << "urls in the running instance.";
+            return 0;
+
+        case SingleInstance::NotResponding:
+            // Starting anyways would open the urls twice and both
+            // instances would write the same configuration.
+            qWarning() << "Another instance of Kristall is running, but doesn't respond. Use --new-instance to start a separate instance.";
+            return 1;
+
+        case SingleInstance::NotRunning:
+            break;
+        }
+
+        // Listen right away, so invocations started while the window
+        // is built don't start another instance. Their urls are opened
+        // once the tabs of this instance exist.
+        if(instance.listen()) {
+            QObject::connect(&instance, &SingleInstance::urlsReceived, &app, [&](QList<QUrl> const & urls) {
+                if(window_ready) {
+                    openForwardedUrls(*main_window, urls);
+                } else {
+                    pending_forwards.append(urls);
+                }
+            });
+        }
+    }
+
     kristall::dirs::offline_pages = derive_dir(kristall::dirs::cache_root, "offline-pages");
     kristall::dirs::themes = derive_dir(kristall::dirs::config_root, "themes");
 
@@ -142,12 +397,18 @@ int main(int argc, char *argv[])
     kristall::dirs::styles.setNameFilters(QStringList { "*.kthm" });
     kristall::dirs::styles.setFilter(QDir::Files);
 
+    // The history is loaded in the background, so completing doesn't wait for it
+    kristall::global_history.setLogFile(kristall::dirs::config_root.absoluteFilePath("history.log"));
+    kristall::global_history.load();
+
     QSettings app_settings {
         kristall::dirs::config_root.absoluteFilePath("config.ini"),
                 QSettings::IniFormat
     };
     app_settings_ptr = &app_settings;
 
+    kristall::startup.mark("command line");
+
     {
         QSettings deprecated_settings { "xqTechnologies", "Kristall" };
         if(QFile(deprecated_settings.fileName()).exists())
@@ -266,6 +527,8 @@ int main(int argc, char *argv[])
         app_settings.endArray();
     }
 
+    kristall::startup.mark("migration");
+
     kristall::settings = &app_settings;
 
     kristall::options.load(app_settings);
@@ -274,17 +537,8 @@ int main(int argc, char *argv[])
     kristall::protocols.load(app_settings);
     app_settings.endGroup();
 
-    app_settings.beginGroup("Client Identities");
-    kristall::identities.load(app_settings);
-    app_settings.endGroup();
-
-    app_settings.beginGroup("Trusted Servers");
-    kristall::trust::gemini.load(app_settings);
-    app_settings.endGroup();
-
-    app_settings.beginGroup("Trusted HTTPS Servers");
-    kristall::trust::https.load(app_settings);
-    app_settings.endGroup();
+    // Client identities and trust stores are loaded on first use,
+    // see kristall::ensureIdentitiesLoaded() and kristall::trust::ensureLoaded().
 
     app_settings.beginGroup("Theme");
     kristall::document_style.load(app_settings);
@@ -294,33 +548,65 @@ int main(int argc, char *argv[])
     kristall::favourites.load(app_settings);
     app_settings.endGroup();
 
+    app_settings.beginGroup("Permanent Redirects");
+    kristall::redirects.load(app_settings);
+    app_settings.endGroup();
+
+    kristall::startup.mark("settings");
+
+    if(headless)
+    {
+        // Rendering only needs the document style loaded above,
+        // so the theme, window and background services are skipped.
+        HeadlessBrowser browser;
+        int const exit_code = browser.run(urls, dump_format, render_stats);
+
+#ifdef KRISTALL_TRACING
+        if(not trace_file.isEmpty())
+            writeTrace(trace_file);
+#endif
+
+        return exit_code;
+    }
+
     kristall::setTheme(kristall::options.theme);
 
+    kristall::startup.mark("theme");
+
+    kristall::memory.start();
+
+    kristall::search_index.setDocumentLimit(kristall::options.search_index_limit);
+    kristall::search_index.start(kristall::dirs::cache_root.absoluteFilePath("search-index.bin"));
+
     MainWindow w(&app);
     main_window = &w;
 
-    auto urls = cli_parser.positionalArguments();
+    kristall::startup.mark("main window");
+
+    bool session_restored = false;
+    if(kristall::options.restore_session) {
+        app_settings.beginGroup("Session");
+        session_restored = w.restoreSession(app_settings);
+        app_settings.endGroup();
+    }
+
     if(urls.size() > 0) {
-        for(const auto &url_str : urls) {
-            QUrl url { url_str };
-            if (url.isRelative()) {
-                if (QFile::exists(url_str)) {
-                    url = QUrl::fromLocalFile(QFileInfo(url_str).absoluteFilePath());
-                } else {
-                    url = QUrl("gemini://" + url_str);
-                }
-            }
-            if(url.isValid()) {
-                w.addNewTab(false, url);
-            } else {
-                qDebug() << "Invalid url: " << url_str;
-            }
+        for(const auto &url : urls) {
+            w.addNewTab(false, url);
         }
     }
-    else {
+    else if(not session_restored) {
         w.addEmptyTab(true, true);
     }
 
+    kristall::startup.mark("tabs");
+
+    window_ready = true;
+    for(auto const & forwarded : pending_forwards) {
+        openForwardedUrls(w, forwarded);
+    }
+    pending_forwards.clear();
+
     app_settings.beginGroup("Window State");
     if(app_settings.contains("geometry")) {
         w.restoreGeometry(app_settings.value("geometry").toByteArray());
@@ -332,16 +618,27 @@ int main(int argc, char *argv[])
 
     w.show();
 
+    kristall::startup.mark("show");
+
     int exit_code = app.exec();
 
+    kristall::search_index.stop();
+
     if (!closing_state_saved)
         kristall::saveWindowState();
 
+#ifdef KRISTALL_TRACING
+    if(not trace_file.isEmpty())
+        writeTrace(trace_file);
+#endif
+
     return exit_code;
 }
 
 void GenericSettings::load(QSettings &settings)
 {
+    KRISTALL_TRACE("load options", "settings");
+
     network_timeout = settings.value("network_timeout", 5000).toInt();
     start_page = settings.value("start_page", "about:favourites").toString();
     search_engine = settings.value("search_engine", "gemini://geminispace.info/search?%1").toString();
@@ -404,10 +701,17 @@ void GenericSettings::load(QSettings &settings)
     cache_threshold = settings.value("cache_threshold", 125).toInt();
     cache_life = settings.value("cache_life", 15).toInt();
     cache_unlimited_life = settings.value("cache_unlimited_life", true).toBool();
+
+    tab_hibernation_timeout = settings.value("tab_hibernation_timeout", 30).toInt();
+    memory_budget = settings.value("memory_budget", 1024).toInt();
+    search_index_limit = settings.value("search_index_limit", 250000).toInt();
+    restore_session = settings.value("restore_session", false).toBool();
 }
 
 void GenericSettings::save(QSettings &settings) const
 {
+    KRISTALL_TRACE("save options", "settings");
+
     settings.setValue("start_page", this->start_page);
     settings.setValue("search_engine", this->search_engine);
     settings.setValue("text_display", (text_display == FormattedText) ? "fancy" : "plain");
@@ -453,6 +757,11 @@ void GenericSettings::save(QSettings &settings) const
     settings.setValue("cache_life", cache_life);
     settings.setValue("cache_unlimited_life", cache_unlimited_life);
 
+    settings.setValue("tab_hibernation_timeout", tab_hibernation_timeout);
+    settings.setValue("memory_budget", memory_budget);
+    settings.setValue("search_index_limit", search_index_limit);
+    settings.setValue("restore_session", restore_session);
+
     if (kristall::EMOJIS_SUPPORTED)
     {
         // Save emoji pref only if emojis are supported, so if user changes to a build
@@ -464,6 +773,8 @@ void GenericSettings::save(QSettings &settings) const
 
 void kristall::saveSettings()
 {
+    KRISTALL_TRACE("save settings", "settings");
+
     assert(app_settings_ptr != nullptr);
     QSettings & app_settings = *app_settings_ptr;
 
@@ -475,22 +786,33 @@ void kristall::saveSettings()
     kristall::protocols.save(app_settings);
     app_settings.endGroup();
 
-    app_settings.beginGroup("Client Identities");
-    kristall::identities.save(app_settings);
-    app_settings.endGroup();
+    // Stores that were never loaded are unchanged
+    if(identities_loaded)
+    {
+        app_settings.beginGroup("Client Identities");
+        kristall::identities.save(app_settings);
+        app_settings.endGroup();
+    }
 
-    app_settings.beginGroup("Trusted Servers");
-    kristall::trust::gemini.save(app_settings);
-    app_settings.endGroup();
+    if(trust_loaded)
+    {
+        app_settings.beginGroup("Trusted Servers");
+        kristall::trust::gemini.save(app_settings);
+        app_settings.endGroup();
 
-    app_settings.beginGroup("Trusted HTTPS Servers");
-    kristall::trust::https.save(app_settings);
-    app_settings.endGroup();
+        app_settings.beginGroup("Trusted HTTPS Servers");
+        kristall::trust::https.save(app_settings);
+        app_settings.endGroup();
+    }
 
     app_settings.beginGroup("Theme");
     kristall::document_style.save(app_settings);
     app_settings.endGroup();
 
+    app_settings.beginGroup("Permanent Redirects");
+    kristall::redirects.save(app_settings);
+    app_settings.endGroup();
+
     kristall::options.save(app_settings);
 
     app_settings.sync();
@@ -588,6 +910,8 @@ void kristall::setUiDensity(UIDensity density, bool previewing)
 
 void kristall::saveWindowState()
 {
+    KRISTALL_TRACE("save window state", "settings");
+
     closing_state_saved = true;
 
     app_settings_ptr->beginGroup("Window State");
@@ -595,5 +919,10 @@ void kristall::saveWindowState()
     app_settings_ptr->setValue("state", main_window->saveState());
     app_settings_ptr->endGroup();
 
+    app_settings_ptr->beginGroup("Session");
+    app_settings_ptr->remove("");
+    main_window->saveSession(*app_settings_ptr);
+    app_settings_ptr->endGroup();
+
     kristall::saveSettings();
 }
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <QMessageBox>
 #include <memory>
+#include <algorithm>
 #include <QShortcut>
 #include <QKeySequence>
 #include <QFile>
@@ -45,6 +46,14 @@ MainWindow::MainWindow(QApplication * app, QWidget *parent) :
     this->ui->history_window->setVisible(false);
     this->ui->bookmarks_window->setVisible(false);
 
+#ifdef KRISTALL_TRACING
+    this->ui->actionRecord_trace->setChecked(kristall::tracer.isEnabled());
+#else
+    // Without trace spans there is nothing to record
+    this->ui->actionRecord_trace->setVisible(false);
+    this->ui->actionExport_trace->setVisible(false);
+#endif
+
     for(QDockWidget * dock : findChildren<QDockWidget *>())
     {
         QAction * act = dock->toggleViewAction();
@@ -125,20 +134,44 @@ MainWindow::MainWindow(QApplication * app, QWidget *parent) :
     connect(this->ui->browser_tabs->tab_bar, &BrowserTabBar::on_newTabClicked, this, [this]() {
         this->addEmptyTab(true, true);
     });
+
+    this->hibernation_timer.setInterval(60 * 1000);
+    connect(&this->hibernation_timer, &QTimer::timeout, this, &MainWindow::hibernateIdleTabs);
+    this->hibernation_timer.start();
+
+    kristall::memory.setEvictor(MemoryGovernor::EvictCache, [](qint64 bytes) {
+        return kristall::cache.evict(bytes);
+    });
+    kristall::memory.setEvictor(MemoryGovernor::HibernateTabs, [this](qint64 bytes) {
+        return this->evictTabs(bytes, false);
+    });
+    kristall::memory.setEvictor(MemoryGovernor::DiscardSnapshots, [this](qint64 bytes) {
+        return this->evictTabs(bytes, true);
+    });
 }
 
 MainWindow::~MainWindow()
 {
+    kristall::memory.setEvictor(MemoryGovernor::HibernateTabs, nullptr);
+    kristall::memory.setEvictor(MemoryGovernor::DiscardSnapshots, nullptr);
     delete ui;
 }
 
-BrowserTab * MainWindow::addEmptyTab(bool focus_new, bool load_default)
+BrowserTab * MainWindow::createTab()
 {
     BrowserTab * tab = new BrowserTab(this);
 
     connect(tab, &BrowserTab::titleChanged, this, &MainWindow::on_tab_titleChanged);
     connect(tab, &BrowserTab::fileLoaded, this, &MainWindow::on_tab_fileLoaded);
     connect(tab, &BrowserTab::requestStateChanged, this, &MainWindow::on_tab_requestStateChanged);
+    connect(tab, &BrowserTab::outlineHeadingChanged, this, &MainWindow::on_tab_outlineHeadingChanged);
+
+    return tab;
+}
+
+BrowserTab * MainWindow::addEmptyTab(bool focus_new, bool load_default)
+{
+    BrowserTab * tab = this->createTab();
 
     int index = this->ui->browser_tabs->addTab(tab, "Page");
 
@@ -174,6 +207,63 @@ BrowserTab * MainWindow::tabAt(int index) const
     return qobject_cast<BrowserTab*>(this->ui->browser_tabs->widget(index));
 }
 
+void MainWindow::hibernateIdleTabs()
+{
+    BrowserTab * current = this->curTab();
+    if(current != nullptr) {
+        current->last_active.start();
+    }
+
+    if(kristall::options.tab_hibernation_timeout <= 0)
+        return;
+
+    qint64 const timeout = 60 * 1000 * qint64(kristall::options.tab_hibernation_timeout);
+    for (int i = 0; i < this->ui->browser_tabs->count(); ++i)
+    {
+        BrowserTab * tab = this->tabAt(i);
+        if(tab == current or tab->isHibernated())
+            continue;
+        if(tab->last_active.hasExpired(timeout)) {
+            tab->hibernate();
+        }
+    }
+}
+
+qint64 MainWindow::evictTabs(qint64 bytes, bool discard_snapshots)
+{
+    BrowserTab * current = this->curTab();
+
+    QVector<BrowserTab*> tabs;
+    for (int i = 0; i < this->ui->browser_tabs->count(); ++i)
+    {
+        BrowserTab * tab = this->tabAt(i);
+        if(tab != current) {
+            tabs.append(tab);
+        }
+    }
+
+    // Least recently used tabs first
+    std::sort(tabs.begin(), tabs.end(), [](BrowserTab * a, BrowserTab * b) {
+        return a->last_active.elapsed() > b->last_active.elapsed();
+    });
+
+    qint64 freed = 0;
+    for(auto * tab : tabs)
+    {
+        if(freed >= bytes)
+            break;
+
+        qint64 const usage = kristall::memory.usageOf(tab);
+        if(discard_snapshots) {
+            tab->discardSnapshot();
+        } else {
+            tab->hibernate();
+        }
+        freed += qMax<qint64>(0, usage - kristall::memory.usageOf(tab));
+    }
+    return freed;
+}
+
 void MainWindow::setUrlPreview(const QUrl &url)
 {
     if(url.isValid()) {
@@ -214,6 +304,16 @@ void MainWindow::setRequestState(RequestState state)
         this->request_status = "Downloading...";
     } break;
 
+    case RequestState::Encrypted:
+    {
+        this->request_status = "Waiting for response...";
+    } break;
+
+    case RequestState::Throttled:
+    {
+        this->request_status = "Waiting for server...";
+    } break;
+
     default:
     {
         this->request_status = "";
@@ -296,6 +396,68 @@ void MainWindow::mousePressEvent(QMouseEvent *event)
     }
 }
 
+void MainWindow::saveSession(QSettings &settings) const
+{
+    settings.setValue("current_tab", this->ui->browser_tabs->currentIndex());
+
+    settings.beginWriteArray("tabs", this->ui->browser_tabs->count());
+    for (int i = 0; i < this->ui->browser_tabs->count(); ++i)
+    {
+        settings.setArrayIndex(i);
+        this->tabAt(i)->saveSession(settings);
+    }
+    settings.endArray();
+}
+
+bool MainWindow::restoreSession(QSettings &settings)
+{
+    int const stored_current = settings.value("current_tab", 0).toInt();
+    int current = 0;
+
+    int const count = settings.beginReadArray("tabs");
+
+    // Adding tabs changes the current tab, which would load each of them
+    this->ui->browser_tabs->blockSignals(true);
+    for (int i = 0; i < count; ++i)
+    {
+        settings.setArrayIndex(i);
+
+        BrowserTab * tab = this->createTab();
+        if(not tab->restoreSession(settings)) {
+            delete tab;
+            continue;
+        }
+
+        int const index = this->ui->browser_tabs->addTab(tab, "Page");
+        tab->updatePageTitle();
+
+        if(i <= stored_current) {
+            current = index;
+        }
+    }
+    this->ui->browser_tabs->blockSignals(false);
+
+    settings.endArray();
+
+    if(this->ui->browser_tabs->count() <= 0)
+        return false;
+
+    this->ui->browser_tabs->setCurrentIndex(current);
+    this->on_browser_tabs_currentChanged(current);
+
+    return true;
+}
+
+void MainWindow::paintEvent(QPaintEvent *event)
+{
+    QMainWindow::paintEvent(event);
+
+    if(not kristall::startup.isFinished()) {
+        kristall::startup.finish();
+        qDebug().noquote() << "startup trace:\n" << kristall::startup.toString();
+    }
+}
+
 void MainWindow::closeEvent(QCloseEvent *event)
 {
     kristall::saveWindowState();
@@ -311,12 +473,21 @@ void MainWindow::on_browser_tabs_currentChanged(int index)
         if(tab != nullptr) {
             this->ui->outline_view->setModel(&tab->outline);
             this->ui->outline_view->expandAll();
+            if(tab->current_heading >= 0) {
+                this->ui->outline_view->setCurrentIndex(tab->outline.headingIndex(tab->current_heading));
+            }
 
             this->ui->history_view->setModel(&tab->history);
 
             this->setFileStatus(tab->current_stats);
 
-            if (tab->needs_rerender)
+            tab->last_active.start();
+
+            if (tab->isHibernated())
+            {
+                tab->wakeUp();
+            }
+            else if (tab->needs_rerender)
             {
                 tab->rerenderPage();
             }
@@ -421,6 +592,7 @@ void MainWindow::on_actionSettings_triggered()
     dialog.setGeminiStyle(kristall::document_style);
     dialog.setProtocols(kristall::protocols);
     dialog.setOptions(kristall::options);
+    kristall::trust::ensureLoaded();
     dialog.setGeminiSslTrust(kristall::trust::gemini);
     dialog.setHttpsSslTrust(kristall::trust::https);
 
@@ -432,7 +604,11 @@ void MainWindow::on_actionSettings_triggered()
 
     kristall::trust::gemini = dialog.geminiSslTrust();
     kristall::trust::https = dialog.httpsSslTrust();
+    // Hosts may have been removed in the dialog
+    kristall::trust::gemini.compact();
+    kristall::trust::https.compact();
     kristall::options = dialog.options();
+    kristall::search_index.setDocumentLimit(kristall::options.search_index_limit);
 
     kristall::protocols = dialog.protocols();
     kristall::document_style = dialog.geminiStyle();
@@ -542,11 +718,13 @@ void MainWindow::setFileStatus(const DocumentStats &stats)
         this->file_cached->setText(stats.loaded_from_cache ? "(cached)" : "");
         this->file_mime->setText(stats.mime_type.toString(false));
         this->load_time->setText(QString("%1 ms").arg(stats.loading_time));
+        this->load_time->setToolTip(stats.timings.toString());
     } else {
         this->file_size->setText("");
         this->file_cached->setText("");
         this->file_mime->setText("");
         this->load_time->setText("");
+        this->load_time->setToolTip("");
     }
 }
 
@@ -605,6 +783,24 @@ void MainWindow::on_tab_fileLoaded(DocumentStats const & stats)
     }
 }
 
+void MainWindow::on_tab_outlineHeadingChanged(const QModelIndex &index)
+{
+    auto * tab = qobject_cast<BrowserTab*>(sender());
+    if(tab == nullptr or tab != this->curTab())
+        return;
+
+    auto * selection = this->ui->outline_view->selectionModel();
+    if(selection == nullptr)
+        return;
+
+    if(index.isValid()) {
+        selection->setCurrentIndex(index, QItemSelectionModel::ClearAndSelect);
+        this->ui->outline_view->scrollTo(index);
+    } else {
+        selection->clear();
+    }
+}
+
 void MainWindow::on_tab_requestStateChanged(RequestState state)
 {
     auto * tab = qobject_cast<BrowserTab*>(sender());
@@ -762,6 +958,7 @@ void MainWindow::on_actionManage_Certificates_triggered()
 {
     CertificateManagementDialog dialog { this };
 
+    kristall::ensureIdentitiesLoaded();
     dialog.setIdentitySet(kristall::identities);
     if(dialog.exec() != QDialog::Accepted)
         return;
@@ -775,3 +972,50 @@ void MainWindow::on_actionShow_document_source_triggered()
 {
     this->viewPageSource();
 }
+
+void MainWindow::on_actionExport_request_timings_triggered()
+{
+    QFileDialog dialog { this };
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setNameFilter("CSV files (*.csv)");
+    dialog.setDefaultSuffix("csv");
+    dialog.selectFile("request-timings.csv");
+
+    if(dialog.exec() != QFileDialog::Accepted)
+        return;
+
+    QString fileName = dialog.selectedFiles().at(0);
+
+    QFile file { fileName };
+
+    if(not file.open(QFile::WriteOnly) or not kristall::timing_log.exportCsv(file))
+    {
+        QMessageBox::warning(this, "Kristall", QString("Could not export request timings:\r\n%1").arg(file.errorString()));
+    }
+}
+
+void MainWindow::on_actionRecord_trace_toggled(bool enabled)
+{
+    kristall::tracer.setEnabled(enabled);
+}
+
+void MainWindow::on_actionExport_trace_triggered()
+{
+    QFileDialog dialog { this };
+    dialog.setAcceptMode(QFileDialog::AcceptSave);
+    dialog.setNameFilter("Trace files (*.json)");
+    dialog.setDefaultSuffix("json");
+    dialog.selectFile("kristall-trace.json");
+
+    if(dialog.exec() != QFileDialog::Accepted)
+        return;
+
+    QString fileName = dialog.selectedFiles().at(0);
+
+    QFile file { fileName };
+
+    if(not file.open(QFile::WriteOnly) or not kristall::tracer.exportJson(file))
+    {
+        QMessageBox::warning(this, "Kristall", QString("Could not export trace:\r\n%1").arg(file.errorString()));
+    }
+}
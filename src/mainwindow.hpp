@@ -4,6 +4,7 @@
 #include <QMainWindow>
 #include <QLabel>
 #include <QSettings>
+#include <QTimer>
 
 #include "favouritecollection.hpp"
 #include "renderers/geminirenderer.hpp"
@@ -49,6 +50,19 @@ public:
 
     void closeEvent(QCloseEvent *event) override;
 
+    void paintEvent(QPaintEvent *event) override;
+
+    //! Stores all open tabs in `settings`.
+    void saveSession(QSettings & settings) const;
+
+    //! Opens the tabs stored with saveSession(). Only the current tab
+    //! is loaded, all other tabs are loaded when they are shown first.
+    //! Returns false if there was no session to restore.
+    bool restoreSession(QSettings & settings);
+
+    //! Hibernates all tabs that weren't shown for longer than the configured timeout.
+    void hibernateIdleTabs();
+
 private slots:
     void on_browser_tabs_currentChanged(int index);
 
@@ -100,12 +114,20 @@ private slots:
 
     void on_actionShow_document_source_triggered();
 
+    void on_actionExport_request_timings_triggered();
+
+    void on_actionRecord_trace_toggled(bool enabled);
+
+    void on_actionExport_trace_triggered();
+
 private: // slots
 
     void on_tab_fileLoaded(DocumentStats const & stats);
 
     void on_tab_requestStateChanged(RequestState state);
 
+    void on_tab_outlineHeadingChanged(QModelIndex const & index);
+
     void on_tab_titleChanged(QString const & title);
 
     void on_tab_locationChanged(QUrl const & url);
@@ -114,10 +136,16 @@ private: // slots
 
 
 private:
+    BrowserTab * createTab();
+
     void setFileStatus(DocumentStats const & stats);
 
     void setRequestState(RequestState state);
 
+    //! Hibernates or discards background tabs, least recently used first,
+    //! until `bytes` bytes were freed. Returns the number of bytes freed.
+    qint64 evictTabs(qint64 bytes, bool discard_snapshots);
+
 public:
     QApplication * application;
 
@@ -132,5 +160,7 @@ private:
 
     QString request_status;
     bool previewing_url = false;
+
+    QTimer hibernation_timer;
 };
 #endif // MAINWINDOW_HPP
@@ -0,0 +1,289 @@
+#include "memorygovernor.hpp"
+#include "kristall.hpp"
+#include "ioutil.hpp"
+
+#include <QDebug>
+#include <QFile>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MemoryGovernor::MemoryGovernor(QObject *parent) : QObject(parent)
+{
+
+}
+
+MemoryGovernor::~MemoryGovernor()
+{
+    this->psi_notifier.reset();
+#ifdef Q_OS_LINUX
+    if(this->psi_fd >= 0) {
+        ::close(this->psi_fd);
+    }
+#endif
+}
+
+void MemoryGovernor::start()
+{
+    this->check_timer.setInterval(check_interval);
+    connect(&this->check_timer, &QTimer::timeout, this, &MemoryGovernor::on_checkTimeout);
+    this->check_timer.start();
+
+    this->watchPressureStallInfo();
+    if(this->psi_notifier == nullptr) {
+        this->watchCgroupEvents();
+    }
+}
+
+void MemoryGovernor::account(Consumer consumer, const void *owner, qint64 bytes)
+{
+    bytes = std::max<qint64>(0, bytes);
+
+    auto it = this->owners.find(owner);
+    if(it == this->owners.end()) {
+        if(bytes == 0)
+            return;
+        it = this->owners.insert(owner, Owner { });
+    }
+
+    this->totals[consumer] += bytes - it->bytes[consumer];
+    it->bytes[consumer] = bytes;
+}
+
+void MemoryGovernor::release(const void *owner)
+{
+    auto it = this->owners.find(owner);
+    if(it == this->owners.end())
+        return;
+
+    for(int i = 0; i < ConsumerCount; i++) {
+        this->totals[i] -= it->bytes[i];
+    }
+    this->owners.erase(it);
+}
+
+void MemoryGovernor::release(Consumer consumer, const void *owner)
+{
+    this->account(consumer, owner, 0);
+}
+
+void MemoryGovernor::setOwnerName(const void *owner, const QString &name)
+{
+    this->owners[owner].name = name;
+}
+
+qint64 MemoryGovernor::totalUsage() const
+{
+    qint64 sum = 0;
+    for(qint64 bytes : this->totals) {
+        sum += bytes;
+    }
+    return sum;
+}
+
+qint64 MemoryGovernor::Owner::total() const
+{
+    qint64 sum = 0;
+    for(qint64 value : this->bytes) {
+        sum += value;
+    }
+    return sum;
+}
+
+void MemoryGovernor::setEvictor(Stage stage, const Evictor &evictor)
+{
+    this->evictors[stage] = evictor;
+}
+
+qint64 MemoryGovernor::evict(qint64 bytes, Stage last_stage)
+{
+    qint64 freed = 0;
+    for(int stage = 0; stage <= last_stage; stage++)
+    {
+        if(freed >= bytes)
+            break;
+        if(auto const & evictor = this->evictors[stage]) {
+            freed += evictor(bytes - freed);
+        }
+    }
+
+    qDebug() << "memory: evicted" << IoUtil::size_human(freed) << "of" << IoUtil::size_human(bytes);
+    if(freed > 0) {
+        emit this->evicted(freed);
+    }
+    return freed;
+}
+
+qint64 MemoryGovernor::budget() const
+{
+    return 1024 * 1024 * qint64(kristall::options.memory_budget);
+}
+
+qint64 MemoryGovernor::residentSetSize()
+{
+#ifdef Q_OS_LINUX
+    // second field of statm is the number of resident pages
+    QFile statm { "/proc/self/statm" };
+    if(not statm.open(QFile::ReadOnly))
+        return -1;
+    auto const fields = statm.readAll().split(' ');
+    if(fields.size() < 2)
+        return -1;
+    bool ok = false;
+    qint64 pages = fields.at(1).toLongLong(&ok);
+    if(not ok)
+        return -1;
+    return pages * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+bool MemoryGovernor::isWatchingPressure() const
+{
+    return (this->psi_notifier != nullptr) or (this->cgroup_watcher != nullptr);
+}
+
+QString MemoryGovernor::consumerName(Consumer consumer)
+{
+    switch(consumer)
+    {
+    case PageCache: return "Page cache";
+    case Documents: return "Rendered documents";
+    case Images: return "Images";
+    case Media: return "Media";
+    case HibernatedTabs: return "Hibernated tabs";
+    default: return "Unknown";
+    }
+}
+
+void MemoryGovernor::on_checkTimeout()
+{
+    qint64 const budget = this->budget();
+    if(budget <= 0)
+        return;
+
+    // Fall back to the accounted memory if the platform can't tell us the RSS
+    qint64 rss = residentSetSize();
+    if(rss < 0)
+        rss = this->totalUsage();
+
+    if(rss <= budget) {
+        this->last_eviction_rss = -1;
+        this->backoff = 0;
+        this->skipped_checks = 0;
+        return;
+    }
+
+    if(this->skipped_checks < this->backoff) {
+        this->skipped_checks += 1;
+        return;
+    }
+    this->skipped_checks = 0;
+
+    // Freed memory isn't always returned to the system and the resident set
+    // contains memory we don't account. If the last eviction didn't shrink
+    // it, evicting again would only throw away pages that have to be loaded
+    // again, so we wait longer before each further attempt.
+    if(this->last_eviction_rss >= 0 and rss >= this->last_eviction_rss) {
+        this->backoff = std::min(max_backoff, std::max(1, 2 * this->backoff));
+        this->last_eviction_rss = -1;
+        qDebug() << "memory: eviction didn't shrink the resident set, skipping" << this->backoff << "checks";
+        return;
+    }
+
+    // We can't free more than we account for
+    qint64 const target = budget - budget * eviction_margin / 100;
+    qint64 const excess = std::min(rss - target, this->totalUsage());
+
+    qDebug() << "memory: resident set size" << IoUtil::size_human(rss) << "exceeds budget" << IoUtil::size_human(budget);
+    this->last_eviction_rss = rss;
+    this->evict(excess, HibernateTabs);
+}
+
+void MemoryGovernor::on_memoryPressure()
+{
+    this->pressure_events += 1;
+
+    // The kernel doesn't tell us how much memory it needs,
+    // so we give back a quarter of what we use.
+    qDebug() << "memory: system reported memory pressure";
+    this->evict(this->totalUsage() / 4);
+}
+
+void MemoryGovernor::watchPressureStallInfo()
+{
+#ifdef Q_OS_LINUX
+    // Notify us when tasks were stalled on memory for 150 ms within 2 s.
+    // Unprivileged processes may only use windows that are multiples of 2 s.
+    int fd = ::open("/proc/pressure/memory", O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if(fd < 0)
+        return;
+
+    char const trigger[] = "some 150000 2000000";
+    if(::write(fd, trigger, sizeof(trigger)) < 0) {
+        ::close(fd);
+        return;
+    }
+
+    this->psi_fd = fd;
+    this->psi_notifier = std::make_unique<QSocketNotifier>(fd, QSocketNotifier::Exception);
+    connect(this->psi_notifier.get(), QOverload<int>::of(&QSocketNotifier::activated), this, &MemoryGovernor::on_memoryPressure);
+    qDebug() << "memory: watching pressure stall information";
+#endif
+}
+
+void MemoryGovernor::watchCgroupEvents()
+{
+#ifdef Q_OS_LINUX
+    // cgroup v2 reports "0::/path" as our cgroup
+    QFile cgroup { "/proc/self/cgroup" };
+    if(not cgroup.open(QFile::ReadOnly))
+        return;
+
+    QString path;
+    for(auto const & line : cgroup.readAll().split('\n'))
+    {
+        if(line.startsWith("0::")) {
+            path = QString::fromUtf8(line.mid(3));
+            break;
+        }
+    }
+    if(path.isEmpty())
+        return;
+
+    this->cgroup_events_path = "/sys/fs/cgroup" + path + "/memory.events";
+    if(not QFile::exists(this->cgroup_events_path))
+        return;
+
+    auto const read_high_events = [this]() -> qint64 {
+        QFile events { this->cgroup_events_path };
+        if(not events.open(QFile::ReadOnly))
+            return -1;
+        for(auto const & line : events.readAll().split('\n'))
+        {
+            if(line.startsWith("high ")) {
+                return line.mid(5).toLongLong();
+            }
+        }
+        return -1;
+    };
+
+    this->cgroup_high_events = read_high_events();
+
+    this->cgroup_watcher = std::make_unique<QFileSystemWatcher>();
+    this->cgroup_watcher->addPath(this->cgroup_events_path);
+    connect(this->cgroup_watcher.get(), &QFileSystemWatcher::fileChanged, this, [this, read_high_events]() {
+        qint64 const high_events = read_high_events();
+        if(high_events > this->cgroup_high_events) {
+            this->on_memoryPressure();
+        }
+        this->cgroup_high_events = high_events;
+    });
+    qDebug() << "memory: watching" << this->cgroup_events_path;
+#endif
+}
@@ -0,0 +1,154 @@
+#ifndef MEMORYGOVERNOR_HPP
+#define MEMORYGOVERNOR_HPP
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <QFileSystemWatcher>
+#include <functional>
+#include <memory>
+
+//! Keeps the memory usage of kristall below a single configurable budget.
+//! Memory consumers report their (estimated) usage through account() and
+//! release(), the governor compares the resident set size with the budget
+//! and evicts memory in order of the cost to restore it when the budget is
+//! exceeded or the system reports memory pressure. Snapshots of hibernated
+//! tabs are only discarded under memory pressure reported by the system.
+class MemoryGovernor : public QObject
+{
+    Q_OBJECT
+public:
+    enum Consumer {
+        PageCache = 0, //!< Bodies stored in the CacheHandler
+        Documents, //!< Rendered text documents and their sources
+        Images, //!< Decoded images in tabs
+        Media, //!< Buffers of the media player
+        HibernatedTabs, //!< Compressed snapshots of hibernated tabs
+        ConsumerCount,
+    };
+
+    //! Eviction stages, ordered by the cost to restore the evicted data.
+    enum Stage {
+        EvictCache = 0, //!< Drop the least recently cached pages
+        HibernateTabs, //!< Release the rendered documents of background tabs
+        DiscardSnapshots, //!< Drop the snapshots of hibernated tabs, they are reloaded when shown
+        StageCount,
+    };
+
+    //! Frees up to the given number of bytes and returns the number of bytes freed.
+    using Evictor = std::function<qint64(qint64 bytes)>;
+
+    //! Memory accounted for a single owner
+    struct Owner
+    {
+        QString name;
+        qint64 bytes[ConsumerCount] = { };
+
+        qint64 total() const;
+    };
+
+    //! Interval in which the resident set size is checked against the budget
+    static constexpr int check_interval = 10000;
+
+    //! Percentage of the budget an eviction frees below the budget, so
+    //! the next check doesn't immediately exceed it again
+    static constexpr int eviction_margin = 10;
+
+    //! Maximum number of checks skipped after evictions that didn't shrink the resident set
+    static constexpr int max_backoff = 32;
+
+public:
+    explicit MemoryGovernor(QObject *parent = nullptr);
+    ~MemoryGovernor();
+
+    //! Starts watching the memory usage. Must be called after the application was created.
+    void start();
+
+    //! Sets the memory used by `consumer` for `owner` to `bytes`.
+    void account(Consumer consumer, void const * owner, qint64 bytes);
+
+    //! Removes all memory accounted for `owner`.
+    void release(void const * owner);
+
+    //! Removes the memory accounted for `owner` by `consumer`.
+    void release(Consumer consumer, void const * owner);
+
+    //! Sets the name `owner` is listed with on about:memory.
+    void setOwnerName(void const * owner, QString const & name);
+
+    qint64 usage(Consumer consumer) const {
+        return this->totals[consumer];
+    }
+
+    qint64 usageOf(void const * owner) const {
+        return this->owners.value(owner).total();
+    }
+
+    qint64 totalUsage() const;
+
+    //! Returns all owners that have memory accounted.
+    QList<Owner> allOwners() const {
+        return this->owners.values();
+    }
+
+    void setEvictor(Stage stage, Evictor const & evictor);
+
+    //! Frees at least `bytes` bytes if possible, running the eviction stages
+    //! in order up to and including `last_stage`.
+    qint64 evict(qint64 bytes, Stage last_stage = DiscardSnapshots);
+
+    //! Returns the memory budget in bytes or 0 if there is none.
+    qint64 budget() const;
+
+    //! Returns the resident set size of the process in bytes or -1 if unknown.
+    static qint64 residentSetSize();
+
+    //! Returns true if the kernel can notify us about memory pressure.
+    bool isWatchingPressure() const;
+
+    int pressureEventCount() const {
+        return this->pressure_events;
+    }
+
+    static QString consumerName(Consumer consumer);
+
+signals:
+    void evicted(qint64 bytes);
+
+private: // slots
+    void on_checkTimeout();
+
+    void on_memoryPressure();
+
+private:
+    void watchPressureStallInfo();
+
+    void watchCgroupEvents();
+
+private:
+    QHash<void const *, Owner> owners;
+
+    //! Sum of the owners' usage per consumer, updated whenever an owner changes
+    qint64 totals[ConsumerCount] = { };
+    Evictor evictors[StageCount];
+
+    QTimer check_timer;
+
+    int psi_fd = -1;
+    std::unique_ptr<QSocketNotifier> psi_notifier;
+    std::unique_ptr<QFileSystemWatcher> cgroup_watcher;
+    QString cgroup_events_path;
+    qint64 cgroup_high_events = 0;
+
+    int pressure_events = 0;
+
+    //! Resident set size when the budget check evicted memory the last time, -1 if it didn't
+    qint64 last_eviction_rss = -1;
+    int backoff = 0;
+    int skipped_checks = 0;
+};
+
+#endif // MEMORYGOVERNOR_HPP
@@ -0,0 +1,150 @@
+#include "networkarchive.hpp"
+#include "ioutil.hpp"
+
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+#include <algorithm>
+
+static const int ARCHIVE_VERSION = 1;
+
+bool NetworkArchive::startRecording(const QString &file_name)
+{
+    this->record_file.close();
+    this->record_file.setFileName(file_name);
+    if(not this->record_file.open(QFile::WriteOnly | QFile::Append)) {
+        qDebug() << "failed to open network archive" << file_name << this->record_file.errorString();
+        return false;
+    }
+
+    if(this->record_file.size() == 0) {
+        QJsonObject header {
+            { "format", "kristall-archive" },
+            { "version", ARCHIVE_VERSION },
+            { "created", QDateTime::currentDateTimeUtc().toString(Qt::ISODateWithMs) },
+        };
+        this->record_file.write(QJsonDocument(header).toJson(QJsonDocument::Compact));
+        this->record_file.write("\n");
+    }
+    this->record_file.flush();
+
+    qDebug() << "recording network archive to" << file_name;
+    return true;
+}
+
+void NetworkArchive::record(const Entry &entry)
+{
+    if(not this->record_file.isOpen())
+        return;
+
+    // Entries are flushed right away, so a crash only loses the current response
+    this->record_file.write(encode(entry));
+    this->record_file.flush();
+    this->recorded_count += 1;
+}
+
+bool NetworkArchive::startReplay(const QString &file_name)
+{
+    QFile file { file_name };
+    if(not file.open(QFile::ReadOnly)) {
+        qDebug() << "failed to open network archive" << file_name << file.errorString();
+        return false;
+    }
+
+    this->entries.clear();
+    this->entries_by_url.clear();
+    this->replayed_by_url.clear();
+
+    while(not file.atEnd())
+    {
+        Entry entry;
+        if(not decode(file.readLine(), entry))
+            continue;
+
+        this->entries_by_url[IoUtil::uniformUrlString(entry.url)].append(this->entries.size());
+        this->entries.append(entry);
+    }
+
+    this->replaying = true;
+    qDebug() << "replaying" << this->entries.size() << "responses from" << file_name;
+    return true;
+}
+
+void NetworkArchive::setReplayScale(double scale)
+{
+    this->replay_scale = std::max(0.0, scale);
+}
+
+const NetworkArchive::Entry *NetworkArchive::next(const QUrl &url)
+{
+    QString const key = IoUtil::uniformUrlString(url);
+
+    auto it = this->entries_by_url.constFind(key);
+    if(it == this->entries_by_url.constEnd())
+        return nullptr;
+
+    int & replayed = this->replayed_by_url[key];
+    int const index = std::min(replayed, it->size() - 1);
+    replayed += 1;
+    return &this->entries.at(it->at(index));
+}
+
+QByteArray NetworkArchive::encode(const Entry &entry)
+{
+    QJsonObject timings;
+    for(int i = 0; i < RequestTimings::PhaseCount; i++)
+    {
+        qint64 const time = entry.timings.get(RequestTimings::Phase(i));
+        if(time >= 0)
+            timings.insert(RequestTimings::phaseKey(RequestTimings::Phase(i)), double(time));
+    }
+
+    QJsonObject object {
+        { "url", entry.url.toString(QUrl::FullyEncoded) },
+        { "started", entry.timings.started_at.toUTC().toString(Qt::ISODateWithMs) },
+        { "status", entry.status },
+        { "meta", entry.meta },
+        { "size", entry.body.size() },
+        { "body", QString::fromLatin1(entry.body.toBase64()) },
+        { "timings", timings },
+    };
+    if(entry.status == 0)
+        object.insert("error", entry.error);
+
+    return QJsonDocument(object).toJson(QJsonDocument::Compact) + "\n";
+}
+
+bool NetworkArchive::decode(const QByteArray &line, Entry &entry)
+{
+    QJsonParseError error;
+    QJsonDocument const document = QJsonDocument::fromJson(line, &error);
+    if(error.error != QJsonParseError::NoError or not document.isObject())
+        return false;
+
+    QJsonObject const object = document.object();
+
+    // The header line describes the archive
+    if(object.contains("format"))
+        return false;
+
+    entry.url = QUrl(object.value("url").toString(), QUrl::StrictMode);
+    if(not entry.url.isValid())
+        return false;
+
+    entry.status = object.value("status").toInt();
+    entry.meta = object.value("meta").toString();
+    entry.error = object.value("error").toInt();
+    entry.body = QByteArray::fromBase64(object.value("body").toString().toLatin1());
+
+    entry.timings = RequestTimings { };
+    entry.timings.started_at = QDateTime::fromString(object.value("started").toString(), Qt::ISODateWithMs);
+    QJsonObject const timings = object.value("timings").toObject();
+    for(int i = 0; i < RequestTimings::PhaseCount; i++)
+    {
+        QJsonValue const time = timings.value(RequestTimings::phaseKey(RequestTimings::Phase(i)));
+        entry.timings.phases[i] = time.isDouble() ? qint64(time.toDouble()) : -1;
+    }
+
+    return true;
+}
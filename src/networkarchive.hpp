@@ -0,0 +1,89 @@
+#ifndef NETWORKARCHIVE_HPP
+#define NETWORKARCHIVE_HPP
+
+#include <QFile>
+#include <QHash>
+#include <QUrl>
+#include <QVector>
+
+#include "requesttimings.hpp"
+
+//! Archive of the responses a browsing session received.
+//! In record mode every response is appended to the archive file as one
+//! JSON object per line. In replay mode the archive is loaded and the
+//! ArchiveHandler serves its responses instead of the network, so a
+//! session can be repeated with the same documents and timings.
+class NetworkArchive
+{
+public:
+    struct Entry
+    {
+        QUrl url;
+
+        //! Gemini style status of the response: 20 for documents, 1x for input,
+        //! 3x for redirects, 60 for certificate requests and 0 for network errors.
+        int status = 0;
+
+        //! MIME type, redirect target, input prompt, certificate info or error reason
+        QString meta;
+
+        //! ProtocolHandler::NetworkError of network errors
+        int error = 0;
+
+        QByteArray body;
+        RequestTimings timings;
+    };
+
+public:
+    //! Appends all recorded responses to `file_name`.
+    bool startRecording(QString const & file_name);
+
+    bool isRecording() const {
+        return this->record_file.isOpen();
+    }
+
+    //! Appends `entry` to the archive file.
+    void record(Entry const & entry);
+
+    //! Loads `file_name` and enables replaying it.
+    bool startReplay(QString const & file_name);
+
+    bool isReplaying() const {
+        return this->replaying;
+    }
+
+    //! Recorded timings are multiplied with this factor when replayed, 0 replays without delays.
+    double replayScale() const {
+        return this->replay_scale;
+    }
+
+    void setReplayScale(double scale);
+
+    //! Returns the next recorded response for `url`. Responses of the same url
+    //! are replayed in the recorded order, the last one is repeated afterwards.
+    Entry const * next(QUrl const & url);
+
+    int recordedCount() const {
+        return this->recorded_count;
+    }
+
+    int entryCount() const {
+        return this->entries.size();
+    }
+
+private:
+    static QByteArray encode(Entry const & entry);
+    static bool decode(QByteArray const & line, Entry & entry);
+
+private:
+    QFile record_file;
+    int recorded_count = 0;
+
+    bool replaying = false;
+    double replay_scale = 1.0;
+    QVector<Entry> entries;
+    QHash<QString, QVector<int>> entries_by_url;
+    QHash<QString, int> replayed_by_url;
+};
+
+#endif // NETWORKARCHIVE_HPP
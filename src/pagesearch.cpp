@@ -0,0 +1,141 @@
+#include "pagesearch.hpp"
+
+#include <QThreadPool>
+#include <QStringMatcher>
+
+#include <algorithm>
+
+//! Matches are handed to the user interface in batches of this size
+static const int BATCH_SIZE = 500;
+
+//! Maps a text to a form where matching is case insensitive and
+//! typographic quotes match plain ones. The length is preserved,
+//! so positions in the folded text are positions in the original.
+static QString foldText(QString text)
+{
+    for(QChar & c : text)
+    {
+        switch(c.unicode())
+        {
+        case 0x2018: // ‘
+        case 0x2019: // ’
+            c = '\'';
+            break;
+        case 0x201C: // “
+        case 0x201D: // ”
+            c = '"';
+            break;
+        default:
+            c = c.toCaseFolded();
+            break;
+        }
+    }
+    return text;
+}
+
+PageSearch::PageSearch(QObject *parent) :
+    QObject(parent),
+    generation(std::make_shared<QAtomicInt>(0))
+{
+    qRegisterMetaType<QVector<int>>();
+}
+
+PageSearch::~PageSearch()
+{
+    this->cancel();
+}
+
+void PageSearch::start(const QString &text, const QString &needle)
+{
+    this->cancel();
+
+    this->positions.clear();
+    this->length = needle.size();
+
+    if(needle.isEmpty()) {
+        emit this->finished();
+        return;
+    }
+
+    this->running = true;
+
+    auto job = new PageSearchJob(this->generation, text, needle);
+    connect(job, &PageSearchJob::matchesFound, this, &PageSearch::on_jobMatches, Qt::QueuedConnection);
+    connect(job, &PageSearchJob::finished, this, &PageSearch::on_jobFinished, Qt::QueuedConnection);
+    QThreadPool::globalInstance()->start(job);
+}
+
+void PageSearch::cancel()
+{
+    // Results of the old job are ignored from now on
+    this->generation->ref();
+    this->running = false;
+}
+
+void PageSearch::on_jobMatches(int generation, const QVector<int> &positions)
+{
+    if(generation != this->generation->load())
+        return;
+
+    int first = this->positions.size();
+    this->positions.append(positions);
+    emit this->matchesFound(first);
+}
+
+void PageSearch::on_jobFinished(int generation)
+{
+    if(generation != this->generation->load())
+        return;
+
+    this->running = false;
+    emit this->finished();
+}
+
+PageSearchJob::PageSearchJob(std::shared_ptr<QAtomicInt> generation, const QString &text, const QString &needle) :
+    generation(generation),
+    my_generation(generation->load()),
+    text(text),
+    needle(needle)
+{
+    // The job deletes itself in the thread it was created in,
+    // so it's still alive when its queued signals are delivered
+    this->setAutoDelete(false);
+}
+
+void PageSearchJob::run()
+{
+    QString const haystack = foldText(this->text);
+    QStringMatcher const matcher { foldText(this->needle), Qt::CaseSensitive };
+    int const step = std::max(1, this->needle.size());
+
+    QVector<int> batch;
+    int pos = 0;
+    while(not this->isCancelled())
+    {
+        pos = matcher.indexIn(haystack, pos);
+        if(pos < 0)
+            break;
+
+        batch.append(pos);
+        pos += step;
+
+        if(batch.size() >= BATCH_SIZE) {
+            emit this->matchesFound(this->my_generation, batch);
+            batch.clear();
+        }
+    }
+
+    if(not this->isCancelled())
+    {
+        if(not batch.isEmpty())
+            emit this->matchesFound(this->my_generation, batch);
+        emit this->finished(this->my_generation);
+    }
+
+    this->deleteLater();
+}
+
+bool PageSearchJob::isCancelled() const
+{
+    return (this->generation->load() != this->my_generation);
+}
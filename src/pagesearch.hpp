@@ -0,0 +1,83 @@
+#ifndef PAGESEARCH_HPP
+#define PAGESEARCH_HPP
+
+#include <QObject>
+#include <QRunnable>
+#include <QVector>
+#include <QAtomicInt>
+#include <memory>
+
+//! Finds all occurrences of a text in a document snapshot on a worker thread.
+//! Matches are case insensitive and don't distinguish between typographic
+//! and plain quotes. Results arrive in batches, starting a new search
+//! cancels the previous one.
+class PageSearch : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PageSearch(QObject *parent = nullptr);
+    ~PageSearch() override;
+
+    //! Starts searching `needle` in `text`, which must be the plain
+    //! text of the document so positions map to document positions.
+    void start(QString const & text, QString const & needle);
+
+    void cancel();
+
+    //! Positions of the matches found so far
+    QVector<int> const & matches() const {
+        return this->positions;
+    }
+
+    //! Length of each match
+    int matchLength() const {
+        return this->length;
+    }
+
+    bool isRunning() const {
+        return this->running;
+    }
+
+signals:
+    //! New matches were found, starting at index `first` in matches().
+    void matchesFound(int first);
+
+    //! The search is complete and matches() contains all matches.
+    void finished();
+
+private slots:
+    void on_jobMatches(int generation, QVector<int> const & positions);
+    void on_jobFinished(int generation);
+
+private:
+    //! Shared with the running job, which stops once it no longer matches its generation
+    std::shared_ptr<QAtomicInt> generation;
+    QVector<int> positions;
+    int length = 0;
+    bool running = false;
+};
+
+//! Runs on QThreadPool, see PageSearch
+class PageSearchJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    PageSearchJob(std::shared_ptr<QAtomicInt> generation, QString const & text, QString const & needle);
+
+    void run() override;
+
+signals:
+    void matchesFound(int generation, QVector<int> const & positions);
+    void finished(int generation);
+
+private:
+    bool isCancelled() const;
+
+private:
+    std::shared_ptr<QAtomicInt> generation;
+    int my_generation;
+    QString text;
+    QString needle;
+};
+
+#endif // PAGESEARCH_HPP
@@ -0,0 +1,100 @@
+#include "perfstats.hpp"
+
+#include <algorithm>
+
+void PerfStats::Histogram::add(qint64 ms)
+{
+    ms = std::max<qint64>(0, ms);
+
+    if(this->samples.size() < window) {
+        this->samples.append(ms);
+    } else {
+        // The window is full, the oldest sample is replaced
+        qint64 const oldest = this->samples.at(this->next);
+        this->buckets[bucketOf(oldest)] -= 1;
+        this->sum -= oldest;
+        this->samples[this->next] = ms;
+        this->next = (this->next + 1) % window;
+    }
+
+    this->buckets[bucketOf(ms)] += 1;
+    this->sum += ms;
+}
+
+double PerfStats::Histogram::mean() const
+{
+    if(this->samples.isEmpty())
+        return 0.0;
+    return double(this->sum) / this->samples.size();
+}
+
+qint64 PerfStats::Histogram::percentile(int percent) const
+{
+    int const target = (this->samples.size() * percent + 99) / 100;
+
+    int seen = 0;
+    for(int i = 0; i < bucket_count; i++)
+    {
+        seen += this->buckets[i];
+        if(seen >= target and seen > 0)
+            return bucketLimit(i);
+    }
+    return 0;
+}
+
+int PerfStats::Histogram::bucketOf(qint64 ms)
+{
+    int index = 0;
+    while(index < bucket_count - 1 and ms >= bucketLimit(index))
+        index += 1;
+    return index;
+}
+
+qint64 PerfStats::Histogram::bucketLimit(int index)
+{
+    if(index >= bucket_count - 1)
+        return -1;
+    return qint64(1) << index;
+}
+
+void PerfStats::HitRatio::add(bool hit)
+{
+    if(this->samples.size() < window) {
+        this->samples.append(hit);
+    } else {
+        if(this->samples.at(this->next))
+            this->hit_count -= 1;
+        this->samples[this->next] = hit;
+        this->next = (this->next + 1) % window;
+    }
+
+    if(hit)
+        this->hit_count += 1;
+}
+
+void PerfStats::addRender(const QString &mime, qint64 ms)
+{
+    this->render_total.add(ms);
+    entry(this->render_by_mime, mime).add(ms);
+}
+
+void PerfStats::addFetch(const QString &host, qint64 ms)
+{
+    this->fetch_total.add(ms);
+    entry(this->fetch_by_host, host).add(ms);
+}
+
+void PerfStats::addCacheLookup(const QString &host, bool hit)
+{
+    this->cache_total.add(hit);
+    entry(this->cache_by_host, host).add(hit);
+}
+
+template<typename T>
+T & PerfStats::entry(QHash<QString, T> & map, const QString &key)
+{
+    // Limits the memory used when browsing many different hosts
+    if(map.size() >= max_keys and not map.contains(key))
+        return map["other"];
+    return map[key];
+}
@@ -0,0 +1,123 @@
+#ifndef PERFSTATS_HPP
+#define PERFSTATS_HPP
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+//! Rolling statistics about page loads, shown on about:perf.
+//! Every sample updates the histograms right away, so reading
+//! them never needs to walk over the recorded samples.
+class PerfStats
+{
+public:
+    //! Number of samples each histogram remembers
+    static constexpr int window = 200;
+
+    //! Bucket i contains samples below 2^i ms, the last bucket all others
+    static constexpr int bucket_count = 14;
+
+    //! Hosts beyond this number are counted as "other"
+    static constexpr int max_keys = 64;
+
+    //! Distribution of the last `window` durations
+    class Histogram
+    {
+    public:
+        void add(qint64 ms);
+
+        int count() const {
+            return this->samples.size();
+        }
+
+        int bucket(int index) const {
+            return this->buckets[index];
+        }
+
+        double mean() const;
+
+        //! Returns the upper bound of the bucket containing the given percentile in ms,
+        //! or -1 if it falls into the last bucket, which has no upper bound.
+        qint64 percentile(int percent) const;
+
+        static int bucketOf(qint64 ms);
+
+        //! Returns the upper bound of a bucket in ms, -1 for the last one.
+        static qint64 bucketLimit(int index);
+
+    private:
+        QVector<qint64> samples;
+        int next = 0;
+        int buckets[bucket_count] = { };
+        qint64 sum = 0;
+    };
+
+    //! Hits and misses of the last `window` lookups
+    class HitRatio
+    {
+    public:
+        void add(bool hit);
+
+        int count() const {
+            return this->samples.size();
+        }
+
+        int hits() const {
+            return this->hit_count;
+        }
+
+    private:
+        QVector<bool> samples;
+        int next = 0;
+        int hit_count = 0;
+    };
+
+public:
+    //! Records the time BrowserTab::renderPage took for a document of `mime` type.
+    void addRender(QString const & mime, qint64 ms);
+
+    //! Records the time a request to `host` took until it was completed.
+    void addFetch(QString const & host, qint64 ms);
+
+    //! Records whether a page of `host` was found in the cache.
+    void addCacheLookup(QString const & host, bool hit);
+
+    Histogram const & renderTotal() const {
+        return this->render_total;
+    }
+
+    Histogram const & fetchTotal() const {
+        return this->fetch_total;
+    }
+
+    HitRatio const & cacheTotal() const {
+        return this->cache_total;
+    }
+
+    QHash<QString, Histogram> const & renderByMime() const {
+        return this->render_by_mime;
+    }
+
+    QHash<QString, Histogram> const & fetchByHost() const {
+        return this->fetch_by_host;
+    }
+
+    QHash<QString, HitRatio> const & cacheByHost() const {
+        return this->cache_by_host;
+    }
+
+private:
+    template<typename T>
+    static T & entry(QHash<QString, T> & map, QString const & key);
+
+private:
+    Histogram render_total;
+    Histogram fetch_total;
+    HitRatio cache_total;
+
+    QHash<QString, Histogram> render_by_mime;
+    QHash<QString, Histogram> fetch_by_host;
+    QHash<QString, HitRatio> cache_by_host;
+};
+
+#endif // PERFSTATS_HPP
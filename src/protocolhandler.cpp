@@ -1,4 +1,5 @@
 #include "protocolhandler.hpp"
+#include "kristall.hpp"
 
 ProtocolHandler::ProtocolHandler(QObject *parent) : QObject(parent)
 {
@@ -14,6 +15,27 @@ void ProtocolHandler::disableClientCertificate()
 {
 }
 
+void ProtocolHandler::beginTimings()
+{
+    this->request_timings = RequestTimings { };
+    this->request_timings.started_at = QDateTime::currentDateTime();
+    this->timing_clock.start();
+
+    KRISTALL_TRACE_MARK("request started", "network");
+}
+
+void ProtocolHandler::markPhase(RequestTimings::Phase phase)
+{
+    if(not this->timing_clock.isValid())
+        return;
+    if(this->request_timings.phases[phase] >= 0)
+        return;
+    this->request_timings.phases[phase] = this->timing_clock.elapsed();
+
+    // Trace events need names with static storage, the phase keys are literals
+    KRISTALL_TRACE_MARK(RequestTimings::phaseKey(phase), "network");
+}
+
 void ProtocolHandler::emitNetworkError(QAbstractSocket::SocketError error_code, const QString &textual_description)
 {
     NetworkError network_error = UnknownError;
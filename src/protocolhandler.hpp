@@ -2,9 +2,11 @@
 #define GENERICPROTOCOLCLIENT_HPP
 
 #include "cryptoidentity.hpp"
+#include "requesttimings.hpp"
 
 #include <QObject>
 #include <QAbstractSocket>
+#include <QElapsedTimer>
 
 enum class RequestState : int;
 
@@ -27,6 +29,7 @@ public:
         Unauthorized, //!< The requested resource could not be accessed.
         TlsFailure, //!< Unspecified TLS failure
         Timeout, //!< The network connection timed out.
+        SlowDown, //!< The server wants us to wait before sending more requests.
     };
     enum RequestOptions {
         Default = 0,
@@ -45,11 +48,19 @@ public:
 
     virtual bool enableClientCertificate(CryptoIdentity const & ident);
     virtual void disableClientCertificate();
+
+    //! Returns the phase timings of the current or last request.
+    RequestTimings const & timings() const {
+        return this->request_timings;
+    }
 signals:
     //! We successfully transferred some bytes from the server
     void requestProgress(qint64 transferred);
 
-    //! The request completed with the given data and mime type
+    //! The request completed with the given data and mime type.
+    //! `data` is implicitly shared with every consumer (tab, cache, media player, ...),
+    //! so handlers must not modify it afterwards and should drop their reference
+    //! once the signal returned, so the body exists only once in memory.
     void requestComplete(QByteArray const & data, QString const & mime);
 
     //! The state of the request has changed
@@ -71,6 +82,17 @@ signals:
     void hostCertificateLoaded(QSslCertificate const & cert);
 protected:
     void emitNetworkError(QAbstractSocket::SocketError error_code, QString const & textual_description);
+
+    //! Resets the timings, must be called when a new request is started.
+    void beginTimings();
+
+    //! Records that the current request reached `phase`.
+    //! Only the first time a phase is reached is recorded.
+    void markPhase(RequestTimings::Phase phase);
+
+private:
+    QElapsedTimer timing_clock;
+    RequestTimings request_timings;
 };
 
 #endif // GENERICPROTOCOLCLIENT_HPP
@@ -4,6 +4,10 @@
 
 #include <QUrl>
 #include <QFile>
+#include <QDateTime>
+#include <QElapsedTimer>
+
+#include <algorithm>
 
 AboutHandler::AboutHandler()
 {
@@ -18,56 +22,328 @@ bool AboutHandler::supportsScheme(const QString &scheme) const
 bool AboutHandler::startRequest(const QUrl &url, ProtocolHandler::RequestOptions options)
 {
     Q_UNUSED(options)
+
+    this->beginTimings();
+
     if (url.path() == "blank")
     {
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete("", "text/gemini");
     }
     else if (url.path() == "favourites")
+    {
+        // The start page usually is about:favourites, so the
+        // document is only regenerated after the favourites changed
+        static QByteArray document;
+        static quint64 document_revision = 0;
+
+        if(document.isEmpty() or document_revision != kristall::favourites.revision())
+        {
+            document.clear();
+            document.append("# Favourites\n");
+
+            QString current_group;
+
+            for (auto const &fav : kristall::favourites.allFavourites())
+            {
+                if(current_group != fav.first) {
+
+                    document.append("\n");
+                    document.append(QString("## %1\n").arg(fav.first).toUtf8());
+
+                    current_group = fav.first;
+                }
+
+                if(fav.second->title.isEmpty()) {
+                    document.append("=> " + fav.second->destination.toString().toUtf8() + "\n");
+                } else {
+                    document.append("=> " + fav.second->destination.toString().toUtf8() + " " + fav.second->title.toUtf8() + "\n");
+                }
+            }
+
+            document_revision = kristall::favourites.revision();
+        }
+
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(document, "text/gemini");
+    }
+    else if (url.path() == "cache")
     {
         QByteArray document;
+        document.append("# Cache information\n");
 
-        document.append("# Favourites\n");
+        document.append(QString(
+            "In-memory cache usage:\n"
+            "* %1 used\n"
+            "* %2 pages in cache\n")
+            .arg(IoUtil::size_human(kristall::cache.size()), QString::number(kristall::cache.pageCount())).toUtf8());
 
-        QString current_group;
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(document, "text/gemini");
+    }
+    else if (url.path() == "search")
+    {
+        QString query = url.query(QUrl::FullyDecoded).trimmed();
+        if (query.isEmpty())
+        {
+            emit this->inputRequired("Search the pages you visited", false);
+            return true;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        auto results = kristall::search_index.search(query, 50);
+
+        QByteArray document;
+        document.append(QString("# Search results for \"%1\"\n").arg(query).toUtf8());
+        document.append(QString("%1 of %2 indexed pages found in %3 ms.\n")
+            .arg(results.size())
+            .arg(kristall::search_index.documentCount())
+            .arg(timer.elapsed())
+            .toUtf8());
+        if (not kristall::search_index.isLoaded())
+        {
+            document.append("The index is still being loaded, so some pages may be missing.\n");
+        }
+        document.append("=> about:search New search\n");
 
-        for (auto const &fav : kristall::favourites.allFavourites())
+        for (auto const & result : results)
         {
-            if(current_group != fav.first) {
+            document.append("\n");
+            document.append(QString("=> %1 %2\n").arg(result.url, result.title.isEmpty() ? result.url : result.title).toUtf8());
+            if (not result.summary.isEmpty())
+            {
+                document.append(QString("> %1\n").arg(result.summary).toUtf8());
+            }
+        }
 
-                document.append("\n");
-                document.append(QString("## %1\n").arg(fav.first).toUtf8());
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(document, "text/gemini");
+    }
+    else if (url.path() == "history")
+    {
+        QByteArray document;
+        document.append("# History\n");
+        document.append(QString("%1 pages were visited.\n").arg(kristall::global_history.size()).toUtf8());
+
+        document.append("\n## Recently visited\n");
+        for (auto const & entry : kristall::global_history.recent(100))
+        {
+            QString title = entry.title.isEmpty() ? entry.url : entry.title;
+            document.append(QString("=> %1 %2 (%3)\n")
+                .arg(entry.url, title, QDateTime::fromSecsSinceEpoch(entry.last_visit).toString(Qt::DefaultLocaleShortDate))
+                .toUtf8());
+        }
+
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(document, "text/gemini");
+    }
+    else if (url.path() == "memory")
+    {
+        QByteArray document;
+        document.append("# Memory usage\n");
 
-                current_group = fav.first;
+        qint64 const rss = MemoryGovernor::residentSetSize();
+        qint64 const budget = kristall::memory.budget();
+
+        document.append(QString(
+            "* Resident set size: %1\n"
+            "* Memory budget: %2\n"
+            "* Memory pressure notifications: %3\n")
+            .arg(rss >= 0 ? IoUtil::size_human(rss) : "unknown",
+                 budget > 0 ? IoUtil::size_human(budget) : "unlimited",
+                 kristall::memory.isWatchingPressure()
+                    ? QString("%1 received").arg(kristall::memory.pressureEventCount())
+                    : "not available").toUtf8());
+
+        document.append("\n## Breakdown\n");
+        for (int i = 0; i < MemoryGovernor::ConsumerCount; i++)
+        {
+            auto const consumer = MemoryGovernor::Consumer(i);
+            document.append(QString("* %1: %2\n")
+                .arg(MemoryGovernor::consumerName(consumer), IoUtil::size_human(kristall::memory.usage(consumer)))
+                .toUtf8());
+        }
+        document.append(QString("* Total: %1\n")
+            .arg(IoUtil::size_human(kristall::memory.totalUsage())).toUtf8());
+
+        document.append("\n## Owners\n");
+        auto owners = kristall::memory.allOwners();
+        std::sort(owners.begin(), owners.end(), [](MemoryGovernor::Owner const & a, MemoryGovernor::Owner const & b) {
+            return a.total() > b.total();
+        });
+        for (auto const & owner : owners)
+        {
+            QStringList parts;
+            for (int i = 0; i < MemoryGovernor::ConsumerCount; i++)
+            {
+                if (owner.bytes[i] > 0)
+                    parts << QString("%1 %2").arg(MemoryGovernor::consumerName(MemoryGovernor::Consumer(i)).toLower(), IoUtil::size_human(owner.bytes[i]));
             }
+            document.append(QString("* %1: %2%3\n")
+                .arg(owner.name.isEmpty() ? "Unnamed" : owner.name,
+                     IoUtil::size_human(owner.total()),
+                     parts.isEmpty() ? "" : QString(" (%1)").arg(parts.join(", ")))
+                .toUtf8());
+        }
+
+        document.append("\n## Stores\n");
+        document.append(QString("* Page cache: %1 pages, %2\n")
+            .arg(kristall::cache.pageCount())
+            .arg(IoUtil::size_human(kristall::cache.size())).toUtf8());
+        document.append(QString("* Search index: %1 pages\n")
+            .arg(kristall::search_index.documentCount()).toUtf8());
+        if (kristall::identitiesLoaded())
+            document.append(QString("* Client identities: %1\n").arg(kristall::identities.identityCount()).toUtf8());
+        else
+            document.append("* Client identities: not loaded\n");
+        if (kristall::trust::isLoaded())
+            document.append(QString("* Trusted hosts: %1 Gemini, %2 HTTPS\n")
+                .arg(kristall::trust::gemini.trusted_hosts.rowCount())
+                .arg(kristall::trust::https.trusted_hosts.rowCount()).toUtf8());
+        else
+            document.append("* Trusted hosts: not loaded\n");
+
+        document.append("\nSizes of rendered documents are estimates.\n");
 
-            if(fav.second->title.isEmpty()) {
-                document.append("=> " + fav.second->destination.toString().toUtf8() + "\n");
-            } else {
-                document.append("=> " + fav.second->destination.toString().toUtf8() + " " + fav.second->title.toUtf8() + "\n");
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(document, "text/gemini");
+    }
+    else if (url.path() == "perf")
+    {
+        QByteArray document;
+        document.append("# Performance\n");
+        document.append(QString("Statistics of the last %1 samples per entry. Percentiles are rounded up to the next power of two.\n")
+            .arg(PerfStats::window).toUtf8());
+
+        auto const histogram_table = [](QHash<QString, PerfStats::Histogram> const & map) {
+            QStringList keys = map.keys();
+            keys.sort();
+
+            // The last bucket has no upper bound, only its lower one is known
+            auto const percentile_text = [](PerfStats::Histogram const & histogram, int percent) {
+                qint64 const limit = histogram.percentile(percent);
+                if(limit < 0)
+                    return QString(">= %1 ms").arg(PerfStats::Histogram::bucketLimit(PerfStats::bucket_count - 2));
+                return QString("%1 ms").arg(limit);
+            };
+
+            QByteArray table;
+            table.append("```\n");
+            table.append(QString("%1 %2 %3 %4 %5\n")
+                .arg(QString { }, -32).arg("count", 6).arg("mean", 10).arg("p50", 10).arg("p95", 10).toUtf8());
+            for (auto const & key : keys)
+            {
+                auto const & histogram = map[key];
+                table.append(QString("%1 %2 %3 %4 %5\n")
+                    .arg(key.left(32), -32)
+                    .arg(histogram.count(), 6)
+                    .arg(QString("%1 ms").arg(histogram.mean(), 0, 'f', 1), 10)
+                    .arg(percentile_text(histogram, 50), 10)
+                    .arg(percentile_text(histogram, 95), 10)
+                    .toUtf8());
+            }
+            table.append("```\n");
+            return table;
+        };
+
+        auto const histogram_bars = [](PerfStats::Histogram const & histogram) {
+            QByteArray bars;
+            bars.append("```\n");
+            for (int i = 0; i < PerfStats::bucket_count; i++)
+            {
+                qint64 const limit = PerfStats::Histogram::bucketLimit(i);
+                QString label = (limit < 0)
+                    ? QString(">= %1 ms").arg(PerfStats::Histogram::bucketLimit(i - 1))
+                    : QString("< %1 ms").arg(limit);
+                int const count = histogram.bucket(i);
+                int const width = (histogram.count() > 0) ? (40 * count + histogram.count() - 1) / histogram.count() : 0;
+                bars.append(QString("%1 %2 %3\n").arg(label, 11).arg(count, 4).arg(QString(width, '#')).toUtf8());
             }
+            bars.append("```\n");
+            return bars;
+        };
+
+        document.append("\n## Render time\n");
+        document.append(histogram_bars(kristall::perf.renderTotal()));
+        document.append("\n### By MIME type\n");
+        document.append(histogram_table(kristall::perf.renderByMime()));
+
+        document.append("\n## Fetch time\n");
+        document.append(histogram_bars(kristall::perf.fetchTotal()));
+        document.append("\n### By host\n");
+        document.append(histogram_table(kristall::perf.fetchByHost()));
+
+        document.append("\n## Cache hits\n");
+        auto const & cache_total = kristall::perf.cacheTotal();
+        document.append(QString("%1 of the last %2 lookups were served from the cache.\n")
+            .arg(cache_total.hits()).arg(cache_total.count()).toUtf8());
+
+        QStringList hosts = kristall::perf.cacheByHost().keys();
+        hosts.sort();
+        document.append("```\n");
+        for (auto const & host : hosts)
+        {
+            auto const & ratio = kristall::perf.cacheByHost()[host];
+            document.append(QString("%1 %2 / %3\n").arg(host.left(32), -32).arg(ratio.hits(), 4).arg(ratio.count(), 4).toUtf8());
         }
+        document.append("```\n");
 
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete(document, "text/gemini");
     }
-    else if (url.path() == "cache")
+    else if (url.path() == "startup")
     {
         QByteArray document;
-        document.append("# Cache information\n");
+        document.append("# Startup time\n");
+
+        if (kristall::startup.isFinished())
+        {
+            document.append(QString("The main window was painted %1 ms after startup.\n")
+                .arg(kristall::startup.total()).toUtf8());
 
-        auto& cache = kristall::cache.getPages();
-        long unsigned cache_usage = 0;
-        int cached_count = 0;
-        for (auto it = cache.begin(); it != cache.end(); ++it, ++cached_count)
+            document.append("\n## Phases\n");
+            for (auto const & phase : kristall::startup.phases())
+            {
+                document.append(QString("* %1: %2 ms\n").arg(phase.name).arg(phase.duration).toUtf8());
+            }
+        }
+        else
         {
-            cache_usage += (long unsigned)it->second->body.size();
+            document.append("The main window wasn't painted yet.\n");
         }
 
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(document, "text/gemini");
+    }
+    else if (url.path() == "redirects")
+    {
+        QByteArray document;
+        document.append("# Permanent redirects\n");
+
+        auto const redirects = kristall::redirects.getAll();
+
         document.append(QString(
-            "In-memory cache usage:\n"
-            "* %1 used\n"
-            "* %2 pages in cache\n")
-            .arg(IoUtil::size_human(cache_usage), QString::number(cached_count)).toUtf8());
+            "Kristall remembers %1 permanently moved locations and requests their new location directly.\n"
+            "Remembered redirects are forgotten after %2 days.\n"
+            "\n"
+            "=> kristall+ctrl:clear-redirects Forget all redirects\n")
+            .arg(redirects.size())
+            .arg(RedirectCache::max_age).toUtf8());
+
+        if (redirects.size() > 0)
+        {
+            document.append("\n## Redirects\n");
+            for (auto const & redirect : redirects)
+            {
+                document.append(QString("=> %1 %2 → %1 (%3)\n")
+                    .arg(redirect.target.toString(QUrl::FullyEncoded),
+                         redirect.source.toString(QUrl::FullyEncoded),
+                         redirect.time_created.toString(Qt::ISODate)).toUtf8());
+            }
+        }
 
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete(document, "text/gemini");
     }
     else
@@ -75,6 +351,7 @@ bool AboutHandler::startRequest(const QUrl &url, ProtocolHandler::RequestOptions
         QFile file(QString(":/about/%1.gemini").arg(url.path()));
         if (file.open(QFile::ReadOnly))
         {
+            this->markPhase(RequestTimings::Completed);
             emit this->requestComplete(file.readAll(), "text/gemini");
         }
         else
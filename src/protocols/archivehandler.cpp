@@ -0,0 +1,133 @@
+#include "archivehandler.hpp"
+#include "kristall.hpp"
+
+ArchiveHandler::ArchiveHandler()
+{
+    this->timer.setSingleShot(true);
+    this->timer.setTimerType(Qt::PreciseTimer);
+    connect(&this->timer, &QTimer::timeout, this, &ArchiveHandler::replayPhases);
+}
+
+bool ArchiveHandler::supportsScheme(const QString &scheme) const
+{
+    // Local documents are never recorded
+    return (scheme != "about") and (scheme != "file");
+}
+
+bool ArchiveHandler::startRequest(const QUrl &url, ProtocolHandler::RequestOptions options)
+{
+    Q_UNUSED(options)
+
+    if(this->isInProgress())
+        return false;
+
+    this->beginTimings();
+    this->clock.start();
+
+    emit this->requestStateChange(RequestState::Started);
+
+    this->target_url = url;
+    this->entry = kristall::archive.next(url);
+    this->next_phase = 0;
+    this->in_progress = true;
+
+    this->replayPhases();
+
+    return true;
+}
+
+bool ArchiveHandler::isInProgress() const
+{
+    return this->in_progress;
+}
+
+bool ArchiveHandler::cancelRequest()
+{
+    this->timer.stop();
+    this->entry = nullptr;
+    this->in_progress = false;
+    return true;
+}
+
+void ArchiveHandler::replayPhases()
+{
+    if(this->entry == nullptr) {
+        this->finish();
+        return;
+    }
+
+    double const scale = kristall::archive.replayScale();
+    qint64 const elapsed = this->clock.elapsed();
+
+    for(; this->next_phase < RequestTimings::PhaseCount; this->next_phase++)
+    {
+        auto const phase = RequestTimings::Phase(this->next_phase);
+
+        qint64 const recorded = this->entry->timings.get(phase);
+        if(recorded < 0)
+            continue;
+
+        qint64 const due = qint64(scale * recorded);
+        if(due > elapsed) {
+            this->timer.start(int(due - elapsed));
+            return;
+        }
+
+        // Completing the request is left to finish()
+        if(phase == RequestTimings::Completed)
+            break;
+
+        this->markPhase(phase);
+        switch(phase)
+        {
+        case RequestTimings::Resolved:
+            emit this->requestStateChange(RequestState::HostFound);
+            break;
+        case RequestTimings::Connected:
+            emit this->requestStateChange(RequestState::Connected);
+            break;
+        case RequestTimings::Encrypted:
+            emit this->requestStateChange(RequestState::Encrypted);
+            break;
+        case RequestTimings::FirstBodyByte:
+            emit this->requestProgress(this->entry->body.size());
+            break;
+        default:
+            break;
+        }
+    }
+
+    this->finish();
+}
+
+void ArchiveHandler::finish()
+{
+    auto const * entry = this->entry;
+    this->entry = nullptr;
+    this->in_progress = false;
+
+    emit this->requestStateChange(RequestState::None);
+
+    if(entry == nullptr) {
+        emit this->networkError(ResourceNotFound, tr("%1 is not in the replayed archive.").arg(this->target_url.toString()));
+        return;
+    }
+
+    int const status = entry->status;
+    if(status == 0) {
+        emit this->networkError(NetworkError(entry->error), entry->meta);
+    }
+    else if(status / 10 == 1) {
+        emit this->inputRequired(entry->meta, status == 11);
+    }
+    else if(status / 10 == 3) {
+        emit this->redirected(QUrl(entry->meta), status == 31);
+    }
+    else if(status / 10 == 6) {
+        emit this->certificateRequired(entry->meta);
+    }
+    else {
+        this->markPhase(RequestTimings::Completed);
+        emit this->requestComplete(entry->body, entry->meta);
+    }
+}
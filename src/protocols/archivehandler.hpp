@@ -0,0 +1,44 @@
+#ifndef ARCHIVEHANDLER_HPP
+#define ARCHIVEHANDLER_HPP
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "protocolhandler.hpp"
+#include "networkarchive.hpp"
+
+//! Serves network requests from the replayed NetworkArchive.
+//! The recorded phases are repeated with the recorded timings,
+//! scaled by NetworkArchive::replayScale().
+class ArchiveHandler : public ProtocolHandler
+{
+    Q_OBJECT
+public:
+    ArchiveHandler();
+
+    bool supportsScheme(QString const & scheme) const override;
+
+    bool startRequest(QUrl const & url, ProtocolHandler::RequestOptions options) override;
+
+    bool isInProgress() const override;
+
+    bool cancelRequest() override;
+
+private slots:
+    void replayPhases();
+
+private:
+    //! Emits the recorded result of the request
+    void finish();
+
+private:
+    QTimer timer;
+    QElapsedTimer clock;
+    QUrl target_url;
+    NetworkArchive::Entry const * entry = nullptr;
+    int next_phase = 0;
+    bool in_progress = false;
+};
+
+#endif // ARCHIVEHANDLER_HPP
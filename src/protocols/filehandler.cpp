@@ -21,6 +21,8 @@ bool FileHandler::startRequest(const QUrl &url, RequestOptions options)
 {
     Q_UNUSED(options)
 
+    this->beginTimings();
+
     QFile file { url.path() };
 
     if (file.open(QFile::ReadOnly))
@@ -28,6 +30,7 @@ bool FileHandler::startRequest(const QUrl &url, RequestOptions options)
         QMimeDatabase db;
         auto mime = db.mimeTypeForUrl(url).name();
         auto data = file.readAll();
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete(data, mime);
     }
     else if (QDir dir = QDir(url.path()); dir.exists())
@@ -50,6 +53,7 @@ bool FileHandler::startRequest(const QUrl &url, RequestOptions options)
                 dir[i]);
         }
 
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete(page.toUtf8(), "text/gemini");
     }
     else
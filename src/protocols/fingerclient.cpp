@@ -15,6 +15,7 @@ FingerClient::FingerClient() : ProtocolHandler(nullptr)
 #endif
 
     connect(&socket, &QAbstractSocket::hostFound, this, [this]() {
+        this->markPhase(RequestTimings::Resolved);
         emit this->requestStateChange(RequestState::HostFound);
     });
     emit this->requestStateChange(RequestState::None);
@@ -40,6 +41,8 @@ bool FingerClient::startRequest(const QUrl &url, RequestOptions options)
     if(url.scheme() != "finger")
         return false;
 
+    this->beginTimings();
+
     this->requested_user = url.userName();
     this->was_cancelled = false;
     socket.connectToHost(url.host(), url.port(79));
@@ -69,14 +72,21 @@ void FingerClient::on_connected()
 {
     auto blob = (requested_user + "\r\n").toUtf8();
 
+    this->markPhase(RequestTimings::Connected);
+
     IoUtil::writeAll(socket, blob);
 
+    this->markPhase(RequestTimings::RequestSent);
+
     emit this->requestStateChange(RequestState::Connected);
 }
 
 void FingerClient::on_readRead()
 {
-    body.append(socket.readAll());
+    QByteArray const data = socket.readAll();
+    if(data.size() > 0)
+        this->markPhase(RequestTimings::FirstBodyByte);
+    body.append(data);
     emit this->requestProgress(body.size());
 }
 
@@ -84,6 +94,7 @@ void FingerClient::on_finished()
 {
     if(not was_cancelled)
     {
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete(this->body, "text/finger");
         was_cancelled = true;
     }
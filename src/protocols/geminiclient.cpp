@@ -22,9 +22,11 @@ GeminiClient::GeminiClient() : ProtocolHandler(nullptr)
 
     // States
     connect(&socket, &QAbstractSocket::hostFound, this, [this]() {
+        this->markPhase(RequestTimings::Resolved);
         emit this->requestStateChange(RequestState::HostFound);
     });
     connect(&socket, &QAbstractSocket::connected, this, [this]() {
+        this->markPhase(RequestTimings::Connected);
         emit this->requestStateChange(RequestState::Connected);
     });
     connect(&socket, &QAbstractSocket::disconnected, this, [this]() {
@@ -57,12 +59,16 @@ bool GeminiClient::startRequest(const QUrl &url, RequestOptions options)
             return false;
     }
 
+    this->beginTimings();
+
     emit this->requestStateChange(RequestState::Started);
 
     this->is_error_state = false;
 
     this->options = options;
 
+    kristall::trust::ensureLoaded();
+
     QSslConfiguration ssl_config = socket.sslConfiguration();
     ssl_config.setProtocol(QSsl::TlsV1_2);
     if(not kristall::trust::gemini.enable_ca)
@@ -119,8 +125,8 @@ bool GeminiClient::cancelRequest()
 
 bool GeminiClient::enableClientCertificate(const CryptoIdentity &ident)
 {
-    this->socket.setLocalCertificate(ident.certificate);
-    this->socket.setPrivateKey(ident.private_key);
+    this->socket.setLocalCertificate(ident.certificate());
+    this->socket.setPrivateKey(ident.privateKey());
     return true;
 }
 
@@ -132,8 +138,12 @@ void GeminiClient::disableClientCertificate()
 
 void GeminiClient::socketEncrypted()
 {
+    this->markPhase(RequestTimings::Encrypted);
+
     emit this->hostCertificateLoaded(this->socket.peerCertificate());
 
+    emit this->requestStateChange(RequestState::Encrypted);
+
     QString request = target_url.toString(QUrl::FormattingOptions(QUrl::FullyEncoded)) + "\r\n";
 
     QByteArray request_bytes = request.toUtf8();
@@ -148,6 +158,8 @@ void GeminiClient::socketEncrypted()
         }
         offset += len;
     }
+
+    this->markPhase(RequestTimings::RequestSent);
 }
 
 void GeminiClient::socketReadyRead()
@@ -158,6 +170,8 @@ void GeminiClient::socketReadyRead()
 
     if(is_receiving_body)
     {
+        if(response.size() > 0)
+            this->markPhase(RequestTimings::FirstBodyByte);
         body.append(response);
         emit this->requestProgress(body.size());
     }
@@ -208,6 +222,8 @@ void GeminiClient::socketReadyRead()
                     return;
                 }
 
+                this->markPhase(RequestTimings::HeaderReceived);
+
                 QString meta = QString::fromUtf8(buffer.data() + 3, buffer.size() - 4);
 
                 int primary_code = buffer[0] - '0';
@@ -233,6 +249,8 @@ void GeminiClient::socketReadyRead()
                     return;
 
                 case 2: // success
+                    if(body.size() > 0)
+                        this->markPhase(RequestTimings::FirstBodyByte);
                     is_receiving_body = true;
                     mime_type = meta;
                     return;
@@ -253,13 +271,23 @@ void GeminiClient::socketReadyRead()
                 }
 
                 case 4: { // temporary failure
+                    if(secondary_code == 4) {
+                        // 44 SLOW DOWN: <META> is the number of seconds to wait
+                        bool ok = false;
+                        int delay = meta.trimmed().toInt(&ok);
+                        if(not ok or delay <= 0)
+                            delay = 1;
+                        kristall::rate_limits.throttle(target_url.host(), delay);
+                        emit networkError(SlowDown, meta);
+                        return;
+                    }
+
                     NetworkError type = UnknownError;
                     switch(secondary_code)
                     {
                     case 1: type = InternalServerError; break;
                     case 2: type = InternalServerError; break;
                     case 3: type = InternalServerError; break;
-                    case 4: type = UnknownError; break;
                     }
                     emit networkError(type, meta);
                     return;
@@ -317,7 +345,11 @@ void GeminiClient::socketDisconnected()
 {
     if(this->is_receiving_body and not this->is_error_state) {
         body.append(socket.readAll());
+        this->markPhase(RequestTimings::Completed);
         emit requestComplete(body, mime_type);
+
+        // Consumers share the body now, don't keep it alive
+        this->body.clear();
     }
 }
 
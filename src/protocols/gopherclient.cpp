@@ -15,6 +15,7 @@ GopherClient::GopherClient(QObject *parent) : ProtocolHandler(parent)
 #endif
 
     connect(&socket, &QAbstractSocket::hostFound, this, [this]() {
+        this->markPhase(RequestTimings::Resolved);
         emit this->requestStateChange(RequestState::HostFound);
     });
     emit this->requestStateChange(RequestState::None);
@@ -40,6 +41,8 @@ bool GopherClient::startRequest(const QUrl &url, RequestOptions options)
     if(url.scheme() != "gopher")
         return false;
 
+    this->beginTimings();
+
     emit this->requestStateChange(RequestState::Started);
 
     // Second char on the URL path denotes the Gopher type
@@ -94,14 +97,21 @@ void GopherClient::on_connected()
     auto searchstr = requested_url.hasQuery() ? "\t" + requested_url.query() : QString();
     auto blob = (requested_url.path().mid(2) + searchstr + "\r\n").toUtf8();
 
+    this->markPhase(RequestTimings::Connected);
+
     IoUtil::writeAll(socket, blob);
 
+    this->markPhase(RequestTimings::RequestSent);
+
     emit this->requestStateChange(RequestState::Connected);
 }
 
 void GopherClient::on_readRead()
 {
-    body.append(socket.readAll());
+    QByteArray const data = socket.readAll();
+    if(data.size() > 0)
+        this->markPhase(RequestTimings::FirstBodyByte);
+    body.append(data);
 
     if(not is_processing_binary) {
         // Strip the "lone dot" from gopher data
@@ -121,6 +131,7 @@ void GopherClient::on_finished()
     if(not was_cancelled)
     {
         this->on_readRead();
+        this->markPhase(RequestTimings::Completed);
         emit this->requestComplete(this->body, mime);
         was_cancelled = true;
     }
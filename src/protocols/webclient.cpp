@@ -4,6 +4,9 @@
 #include <QNetworkRequest>
 #include <QNetworkReply>
 
+//! Upper limit for the body allocated up front from the Content-Length header
+static const qint64 MAX_BODY_RESERVE = 8 * 1024 * 1024; // bytes
+
 WebClient::WebClient() :
     ProtocolHandler(nullptr),
     current_reply(nullptr)
@@ -31,6 +34,8 @@ bool WebClient::startRequest(const QUrl &url, RequestOptions options)
     if(this->current_reply != nullptr)
         return true;
 
+    this->beginTimings();
+
     emit this->requestStateChange(RequestState::StartedWeb);
 
     this->options = options;
@@ -38,6 +43,8 @@ bool WebClient::startRequest(const QUrl &url, RequestOptions options)
 
     QNetworkRequest request(url);
 
+    kristall::trust::ensureLoaded();
+
     auto ssl_config = request.sslConfiguration();
     // ssl_config.setProtocol(QSsl::TlsV1_2);
     if(kristall::trust::https.enable_ca)
@@ -46,8 +53,8 @@ bool WebClient::startRequest(const QUrl &url, RequestOptions options)
         ssl_config.setCaCertificates(QList<QSslCertificate> { });
 
     if(this->current_identity.isValid()) {
-        ssl_config.setLocalCertificate(this->current_identity.certificate);
-        ssl_config.setPrivateKey(this->current_identity.private_key);
+        ssl_config.setLocalCertificate(this->current_identity.certificate());
+        ssl_config.setPrivateKey(this->current_identity.privateKey());
     }
 
     // request.setMaximumRedirectsAllowed(5);
@@ -67,6 +74,23 @@ bool WebClient::startRequest(const QUrl &url, RequestOptions options)
     connect(this->current_reply, &QNetworkReply::sslErrors, this, &WebClient::on_sslErrors);
     connect(this->current_reply, &QNetworkReply::redirected, this, &WebClient::on_redirected);
 
+    // QNetworkReply doesn't expose name resolution and connection,
+    // so only the later phases are recorded for web requests.
+    connect(this->current_reply, &QNetworkReply::encrypted, this, [this]() {
+        this->markPhase(RequestTimings::Encrypted);
+    });
+    connect(this->current_reply, &QNetworkReply::metaDataChanged, this, [this]() {
+        this->markPhase(RequestTimings::HeaderReceived);
+
+        // Allocate the body only once if the server tells us its size. The size
+        // isn't trusted beyond a limit, larger bodies grow while they arrive.
+        bool ok = false;
+        qint64 length = this->current_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong(&ok);
+        if(ok and length > 0) {
+            this->body.reserve(int(qMin<qint64>(length, MAX_BODY_RESERVE)));
+        }
+    });
+
     return true;
 }
 
@@ -99,12 +123,17 @@ void WebClient::disableClientCertificate()
 
 void WebClient::on_data()
 {
-    this->body.append(this->current_reply->readAll());
+    QByteArray const data = this->current_reply->readAll();
+    if(data.size() > 0)
+        this->markPhase(RequestTimings::FirstBodyByte);
+    this->body.append(data);
     emit this->requestProgress(this->body.size());
 }
 
 void WebClient::on_finished()
 {
+    this->markPhase(RequestTimings::Completed);
+
     emit this->requestStateChange(RequestState::None);
 
     emit this->hostCertificateLoaded(this->current_reply->sslConfiguration().peerCertificate());
@@ -145,6 +174,8 @@ void WebClient::on_finished()
         if(not this->suppress_socket_tls_error) {
             emit this->networkError(error, reply->errorString());
         }
+
+        this->body.clear();
     }
     else
     {
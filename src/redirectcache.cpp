@@ -0,0 +1,169 @@
+#include "redirectcache.hpp"
+
+#include <QDebug>
+#include <algorithm>
+
+void RedirectCache::load(QSettings &settings)
+{
+    this->redirects.clear();
+
+    int size = settings.beginReadArray("redirects");
+    for(int i = 0; i < size; i++)
+    {
+        settings.setArrayIndex(i);
+
+        PermanentRedirect redirect;
+        redirect.source = settings.value("source").toUrl();
+        redirect.target = settings.value("target").toUrl();
+        redirect.time_created = settings.value("created").toDateTime();
+
+        if(not redirect.source.isValid() or not redirect.target.isValid())
+            continue;
+        if(this->isExpired(redirect) or not isSameOrigin(redirect.source, redirect.target))
+            continue;
+
+        this->redirects.insert(keyFor(redirect.source), redirect);
+    }
+    settings.endArray();
+}
+
+void RedirectCache::save(QSettings &settings) const
+{
+    auto all = this->getAll();
+
+    settings.remove("redirects");
+    settings.beginWriteArray("redirects", all.size());
+    for(int i = 0; i < all.size(); i++)
+    {
+        settings.setArrayIndex(i);
+
+        settings.setValue("source", all.at(i).source);
+        settings.setValue("target", all.at(i).target);
+        settings.setValue("created", all.at(i).time_created);
+    }
+    settings.endArray();
+}
+
+void RedirectCache::insert(const QUrl &source, const QUrl &target)
+{
+    QString key = keyFor(source);
+    if(key == keyFor(target))
+        return;
+
+    // The redirection policy may ask the user before switching host or
+    // protocol, so these redirections must always go through the server.
+    if(not isSameOrigin(source, target))
+        return;
+
+    this->removeExpired();
+
+    if(not this->redirects.contains(key))
+    {
+        while(this->redirects.size() >= max_entries)
+            this->popOldest();
+    }
+
+    PermanentRedirect redirect;
+    redirect.source = source.adjusted(QUrl::RemoveFragment);
+    redirect.target = target.adjusted(QUrl::RemoveFragment);
+    redirect.time_created = QDateTime::currentDateTime();
+
+    qDebug() << "redirect cache: remembering" << redirect.source << "->" << redirect.target;
+
+    this->redirects.insert(key, redirect);
+}
+
+QUrl RedirectCache::resolve(const QUrl &url) const
+{
+    QUrl result = url;
+
+    // Follow chains of moved documents, but don't get stuck in a loop
+    for(int i = 0; i < max_hops; i++)
+    {
+        auto it = this->redirects.find(keyFor(result));
+        if(it == this->redirects.end() or this->isExpired(*it))
+            break;
+
+        QString fragment = url.fragment(QUrl::FullyEncoded);
+        result = it->target;
+        if(not fragment.isEmpty())
+            result.setFragment(fragment, QUrl::StrictMode);
+    }
+
+    return result;
+}
+
+void RedirectCache::remove(const QUrl &source)
+{
+    this->redirects.remove(keyFor(source));
+}
+
+void RedirectCache::clear()
+{
+    this->redirects.clear();
+}
+
+int RedirectCache::size() const
+{
+    return this->redirects.size();
+}
+
+QVector<PermanentRedirect> RedirectCache::getAll() const
+{
+    QVector<PermanentRedirect> result;
+    result.reserve(this->redirects.size());
+    for(auto const & redirect : this->redirects)
+    {
+        if(not this->isExpired(redirect))
+            result.append(redirect);
+    }
+
+    std::sort(result.begin(), result.end(), [](PermanentRedirect const & a, PermanentRedirect const & b) {
+        return a.time_created < b.time_created;
+    });
+
+    return result;
+}
+
+QString RedirectCache::keyFor(const QUrl &url)
+{
+    return url.toString(QUrl::FullyEncoded | QUrl::RemoveFragment);
+}
+
+bool RedirectCache::isSameOrigin(const QUrl &source, const QUrl &target)
+{
+    return (source.scheme() == target.scheme())
+        and (source.host() == target.host())
+        and (source.port() == target.port());
+}
+
+bool RedirectCache::isExpired(const PermanentRedirect &redirect) const
+{
+    return (redirect.time_created.addDays(max_age) < QDateTime::currentDateTime());
+}
+
+void RedirectCache::removeExpired()
+{
+    for(auto it = this->redirects.begin(); it != this->redirects.end(); )
+    {
+        if(this->isExpired(*it))
+            it = this->redirects.erase(it);
+        else
+            ++it;
+    }
+}
+
+void RedirectCache::popOldest()
+{
+    if(this->redirects.isEmpty())
+        return;
+
+    auto oldest = this->redirects.begin();
+    for(auto it = this->redirects.begin(); it != this->redirects.end(); ++it)
+    {
+        if(it->time_created < oldest->time_created)
+            oldest = it;
+    }
+
+    this->redirects.erase(oldest);
+}
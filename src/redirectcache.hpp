@@ -0,0 +1,70 @@
+#ifndef REDIRECTCACHE_HPP
+#define REDIRECTCACHE_HPP
+
+#include <QHash>
+#include <QUrl>
+#include <QDateTime>
+#include <QVector>
+#include <QSettings>
+
+struct PermanentRedirect
+{
+    QUrl source;
+    QUrl target;
+    QDateTime time_created;
+};
+
+//! Remembers permanent redirections (gemini 31, http 301/308), so
+//! we can send requests to the new location without asking the old
+//! one first. The cache is bounded in size and entries expire.
+//! Only redirections within the same scheme and host are remembered,
+//! the others are subject to the redirection policy on every visit.
+class RedirectCache
+{
+public:
+    //! Maximum number of remembered redirections
+    static constexpr int max_entries = 1000;
+
+    //! Number of days after which a redirection is forgotten
+    static constexpr int max_age = 30;
+
+    //! Maximum number of cached redirections followed for a single url
+    static constexpr int max_hops = 5;
+
+public:
+    void load(QSettings & settings);
+    void save(QSettings & settings) const;
+
+    //! Remembers that `source` has permanently moved to `target`.
+    //! Redirections to another scheme or host are ignored.
+    void insert(QUrl const & source, QUrl const & target);
+
+    //! Returns the location `url` was permanently moved to, or
+    //! `url` itself if we don't know a permanent redirection.
+    QUrl resolve(QUrl const & url) const;
+
+    void remove(QUrl const & source);
+
+    void clear();
+
+    int size() const;
+
+    //! Returns all non-expired redirections, sorted by creation time.
+    QVector<PermanentRedirect> getAll() const;
+
+private:
+    static QString keyFor(QUrl const & url);
+
+    static bool isSameOrigin(QUrl const & source, QUrl const & target);
+
+    bool isExpired(PermanentRedirect const & redirect) const;
+
+    void removeExpired();
+
+    void popOldest();
+
+private:
+    QHash<QString, PermanentRedirect> redirects;
+};
+
+#endif // REDIRECTCACHE_HPP
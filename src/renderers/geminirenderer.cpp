@@ -157,7 +157,7 @@ std::unique_ptr<GeminiDocument> GeminiRenderer::render(
                 fmt.setAnchor(true);
                 fmt.setAnchorNames(QStringList { id });
 
-                outline.appendH3(heading, id);
+                outline.appendH3(heading, id, cursor.position());
 
                 cursor.setBlockFormat(text_style.heading_format);
                 cursor.insertText(replace_quotes(heading), fmt);
@@ -172,7 +172,7 @@ std::unique_ptr<GeminiDocument> GeminiRenderer::render(
                 fmt.setAnchor(true);
                 fmt.setAnchorNames(QStringList { id });
 
-                outline.appendH2(heading, id);
+                outline.appendH2(heading, id, cursor.position());
 
                 cursor.setBlockFormat(text_style.heading_format);
                 cursor.insertText(replace_quotes(heading), fmt);
@@ -187,7 +187,7 @@ std::unique_ptr<GeminiDocument> GeminiRenderer::render(
                 fmt.setAnchor(true);
                 fmt.setAnchorNames(QStringList { id });
 
-                outline.appendH1(heading, id);
+                outline.appendH1(heading, id, cursor.position());
 
                 // Use first heading as the page's title.
                 if (page_title != nullptr && page_title->isEmpty())
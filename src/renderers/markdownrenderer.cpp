@@ -202,17 +202,18 @@ static void renderNode(RenderState &state, cmark_node & node, const QTextCharFor
         }
 
 	auto text = cmark_node_get_literal(cmark_node_first_child(&node));
+        int const heading_position = state.cursor.position();
         switch(cmark_node_get_heading_level(&node)) {
         case 1:
-            state.outline->appendH1(text, QString { });
+            state.outline->appendH1(text, QString { }, heading_position);
 
             // Use first heading as the page's title.
             if (page_title.isEmpty())
                 page_title = text;
 
             break;
-        case 2: state.outline->appendH2(text, QString { }); break;
-        case 3: state.outline->appendH3(text, QString { }); break;
+        case 2: state.outline->appendH2(text, QString { }, heading_position); break;
+        case 3: state.outline->appendH3(text, QString { }, heading_position); break;
         }
 
         renderChildren(state, node, fmt, page_title);
@@ -9,6 +9,10 @@
  *       https://en.wikipedia.org/wiki/VT52#Escape_sequences
  */
 #include "renderhelpers.hpp"
+#include "geminirenderer.hpp"
+#include "gophermaprenderer.hpp"
+#include "markdownrenderer.hpp"
+#include "plaintextrenderer.hpp"
 #include "kristall.hpp"
 
 #include <QByteArray>
@@ -16,6 +20,7 @@
 #include <QTextCursor>
 #include <QTextFrame>
 #include <QTextFrameFormat>
+#include <QRegularExpression>
 
 #include <string>
 #include <iostream>
@@ -374,3 +379,60 @@ void renderhelpers::setPageMargins(QTextDocument *doc, int mh, int mv)
     fmt.setBottomMargin(mv);
     root->setFrameFormat(fmt);
 }
+
+std::unique_ptr<QTextDocument> renderhelpers::renderDocument(
+    QByteArray const & input,
+    MimeType const & mime,
+    QUrl const & root_url,
+    DocumentStyle const & style,
+    DocumentOutlineModel & outline,
+    QString & page_title)
+{
+    if(not mime.is("text"))
+        return nullptr;
+
+    bool const plaintext_only = (kristall::options.text_display == GenericSettings::PlainText);
+
+    if (not plaintext_only and mime.is("text", "gemini"))
+    {
+        KRISTALL_TRACE("render gemini", "render");
+        return GeminiRenderer::render(input, root_url, style, outline, &page_title);
+    }
+    else if (not plaintext_only and mime.is("text", "gophermap"))
+    {
+        KRISTALL_TRACE("render gophermap", "render");
+        return GophermapRenderer::render(input, root_url, style);
+    }
+    else if (not plaintext_only and mime.is("text", "html"))
+    {
+        KRISTALL_TRACE("render html", "render");
+        auto document = std::make_unique<QTextDocument>();
+
+        document->setDefaultFont(style.standard_font);
+        document->setDefaultStyleSheet(style.toStyleSheet());
+        setPageMargins(document.get(), style.margin_h, style.margin_v);
+
+        // Strip inline styles from page, so they don't
+        // conflict with user styles.
+        QString page_html = QString::fromUtf8(input);
+        page_html.replace(QRegularExpression("<style.*?>[\\S\\s]*?</style.*?>", QRegularExpression::CaseInsensitiveOption), "");
+
+        // Strip bgcolor attribute from body. These can screw up user styles too.
+        page_html.replace(QRegularExpression("<body.*bgcolor.*>", QRegularExpression::CaseInsensitiveOption), "<body>");
+
+        document->setHtml(page_html);
+
+        page_title = document->metaInformation(QTextDocument::DocumentTitle);
+        return document;
+    }
+    else if (not plaintext_only and mime.is("text", "markdown"))
+    {
+        KRISTALL_TRACE("render markdown", "render");
+        return MarkdownRenderer::render(input, root_url, style, outline, page_title);
+    }
+    else
+    {
+        KRISTALL_TRACE("render plain text", "render");
+        return PlainTextRenderer::render(input, style);
+    }
+}
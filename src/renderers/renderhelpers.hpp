@@ -4,12 +4,32 @@
 #include <QByteArray>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <memory>
+
+#include "documentstyle.hpp"
+#include "documentoutlinemodel.hpp"
+#include "mimeparser.hpp"
 
 namespace renderhelpers
 {
     void renderEscapeCodes(const QByteArray &input, const QTextCharFormat& format, QTextCursor& cursor);
 
     void setPageMargins(QTextDocument *doc, int mh, int mv);
+
+    //! Renders the UTF-8 encoded text document `input` with the renderer for `mime`,
+    //! or as plain text if there is none or the user prefers plain text.
+    //! Used by the tabs and the headless browser, so both render the same.
+    //! @param root_url   The url that is used to resolve relative links
+    //! @param page_title Receives the title of the document if it has one
+    //! @returns nullptr if `mime` isn't a text type
+    std::unique_ptr<QTextDocument> renderDocument(
+        QByteArray const & input,
+        MimeType const & mime,
+        QUrl const & root_url,
+        DocumentStyle const & style,
+        DocumentOutlineModel & outline,
+        QString & page_title
+    );
 }
 
 #endif
@@ -0,0 +1,79 @@
+#include "requestcoalescer.hpp"
+#include "kristall.hpp"
+
+#include <QDebug>
+
+RequestCoalescer::RequestCoalescer(QObject *parent) : QObject(parent)
+{
+
+}
+
+QString RequestCoalescer::keyFor(const QUrl &url, const CryptoIdentity &identity)
+{
+    QString key = url.toString(QUrl::FullyEncoded | QUrl::RemoveFragment);
+    if(identity.hasMaterial()) {
+        key += " " + identity.fingerprint();
+    }
+    return key;
+}
+
+RequestCoalescer::Role RequestCoalescer::join(const QString &key, void const * requester)
+{
+    auto it = this->requests.find(key);
+    if(it == this->requests.end())
+    {
+        InFlightRequest request;
+        request.owner = requester;
+        this->requests.insert(key, request);
+        return Owner;
+    }
+
+    // The owner restarted the same request, so it keeps owning it
+    if(it->owner == requester)
+        return Owner;
+
+    it->waiters += 1;
+    qDebug() << "coalescing request for" << key << "with" << it->waiters << "waiters";
+    return Waiter;
+}
+
+void RequestCoalescer::leave(const QString &key, void const * requester)
+{
+    auto it = this->requests.find(key);
+    if(it == this->requests.end())
+        return;
+
+    if(it->owner != requester)
+    {
+        it->waiters -= 1;
+        return;
+    }
+
+    bool had_waiters = (it->waiters > 0);
+    this->requests.erase(it);
+
+    if(had_waiters) {
+        emit this->abandoned(key);
+    }
+}
+
+void RequestCoalescer::finish(const QString &key, void const * requester, const QByteArray &data, const QString &mime)
+{
+    auto it = this->requests.find(key);
+    if(it == this->requests.end())
+        return;
+    if(it->owner != requester)
+        return;
+
+    bool had_waiters = (it->waiters > 0);
+    this->requests.erase(it);
+
+    if(had_waiters) {
+        emit this->completed(key, data, mime);
+    }
+}
+
+int RequestCoalescer::inFlightCount() const
+{
+    return this->requests.size();
+}
@@ -0,0 +1,61 @@
+#ifndef REQUESTCOALESCER_HPP
+#define REQUESTCOALESCER_HPP
+
+#include <QObject>
+#include <QHash>
+#include <QUrl>
+#include <QByteArray>
+
+#include "cryptoidentity.hpp"
+
+//! Deduplicates identical network requests that are in flight at the same time.
+//! The first tab requesting a resource becomes the *owner* and performs the
+//! actual fetch, every other tab requesting the same resource attaches to it
+//! as a *waiter* and receives the (implicitly shared) body when the owner completes.
+//! If the owner does not complete with a body (redirect, input, error, cancel, ...),
+//! the request is abandoned and waiters have to perform the request themselves.
+class RequestCoalescer : public QObject
+{
+    Q_OBJECT
+public:
+    enum Role {
+        Owner, //!< No request was in flight, the caller has to perform the request
+        Waiter, //!< Another request is in flight, the caller will be notified by completed() or abandoned()
+    };
+
+public:
+    explicit RequestCoalescer(QObject *parent = nullptr);
+
+    //! Creates the coalescing key for a request. Requests are only coalesced
+    //! when both the canonical url and the used client identity match.
+    static QString keyFor(QUrl const & url, CryptoIdentity const & identity);
+
+    //! Joins the request identified by `key`.
+    Role join(QString const & key, void const * requester);
+
+    //! Detaches `requester` from the request. If `requester` is the owner,
+    //! the request is abandoned.
+    void leave(QString const & key, void const * requester);
+
+    //! Completes the request and hands the body to all waiters.
+    void finish(QString const & key, void const * requester, QByteArray const & data, QString const & mime);
+
+    //! Returns the number of requests currently in flight.
+    int inFlightCount() const;
+
+signals:
+    void completed(QString const & key, QByteArray const & data, QString const & mime);
+
+    void abandoned(QString const & key);
+
+private:
+    struct InFlightRequest
+    {
+        void const * owner = nullptr;
+        int waiters = 0;
+    };
+
+    QHash<QString, InFlightRequest> requests;
+};
+
+#endif // REQUESTCOALESCER_HPP
@@ -0,0 +1,115 @@
+#include "requesttimings.hpp"
+#include "ioutil.hpp"
+
+#include <QStringList>
+
+qint64 RequestTimings::between(Phase from, Phase to) const
+{
+    if(phases[from] < 0 or phases[to] < 0)
+        return -1;
+    return phases[to] - phases[from];
+}
+
+QString RequestTimings::toString() const
+{
+    if(not this->isValid())
+        return QString { };
+
+    QStringList lines;
+    for(int i = 0; i < PhaseCount; i++)
+    {
+        if(phases[i] < 0)
+            continue;
+        lines << QString("%1: %2 ms").arg(phaseName(Phase(i))).arg(phases[i]);
+    }
+    return lines.join("\n");
+}
+
+QString RequestTimings::phaseName(Phase phase)
+{
+    switch(phase)
+    {
+    case Resolved: return "Resolved";
+    case Connected: return "Connected";
+    case Encrypted: return "Encrypted";
+    case RequestSent: return "Request sent";
+    case HeaderReceived: return "Header received";
+    case FirstBodyByte: return "First body byte";
+    case Completed: return "Completed";
+    default: return "Unknown";
+    }
+}
+
+char const * RequestTimings::phaseKey(Phase phase)
+{
+    switch(phase)
+    {
+    case Resolved: return "resolved";
+    case Connected: return "connected";
+    case Encrypted: return "encrypted";
+    case RequestSent: return "request_sent";
+    case HeaderReceived: return "header_received";
+    case FirstBodyByte: return "first_body_byte";
+    case Completed: return "completed";
+    default: return "unknown";
+    }
+}
+
+void RequestTimingLog::add(const QUrl &url, const RequestTimings &timings)
+{
+    if(not timings.isValid())
+        return;
+
+    auto & list = this->entries[url.host()];
+    if(list.size() >= max_entries_per_host)
+        list.removeFirst();
+    list.append(Entry { url, timings });
+}
+
+QVector<RequestTimingLog::Entry> RequestTimingLog::forHost(const QString &host) const
+{
+    return this->entries.value(host);
+}
+
+QStringList RequestTimingLog::hosts() const
+{
+    QStringList result = this->entries.keys();
+    result.sort();
+    return result;
+}
+
+void RequestTimingLog::clear()
+{
+    this->entries.clear();
+}
+
+bool RequestTimingLog::exportCsv(QIODevice &device) const
+{
+    QByteArray csv = "host,url,started_at";
+    for(int i = 0; i < RequestTimings::PhaseCount; i++)
+    {
+        csv += ",";
+        csv += RequestTimings::phaseKey(RequestTimings::Phase(i));
+    }
+    csv += "\n";
+
+    for(auto const & host : this->hosts())
+    {
+        for(auto const & entry : this->entries.value(host))
+        {
+            QString url = entry.url.toString(QUrl::FullyEncoded);
+            url.replace("\"", "\"\"");
+
+            csv += host.toUtf8();
+            csv += ",\"" + url.toUtf8() + "\"";
+            csv += "," + entry.timings.started_at.toString(Qt::ISODateWithMs).toUtf8();
+            for(int i = 0; i < RequestTimings::PhaseCount; i++)
+            {
+                csv += "," + QByteArray::number(entry.timings.phases[i]);
+            }
+            csv += "\n";
+        }
+    }
+
+    return IoUtil::writeAll(device, csv);
+}
@@ -0,0 +1,81 @@
+#ifndef REQUESTTIMINGS_HPP
+#define REQUESTTIMINGS_HPP
+
+#include <QDateTime>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+#include <QStringList>
+#include <QUrl>
+#include <QVector>
+
+//! Timestamps of the phases of a single request.
+//! All values are milliseconds since the request was started,
+//! or -1 if the request never reached that phase.
+struct RequestTimings
+{
+    enum Phase {
+        Resolved = 0, //!< The host name was resolved
+        Connected, //!< The connection to the host was established
+        Encrypted, //!< The TLS handshake completed
+        RequestSent, //!< The request was written to the server
+        HeaderReceived, //!< The response header was received
+        FirstBodyByte, //!< The first byte of the response body was received
+        Completed, //!< The request completed
+        PhaseCount,
+    };
+
+    QDateTime started_at;
+    qint64 phases[PhaseCount] = { -1, -1, -1, -1, -1, -1, -1 };
+
+    bool isValid() const {
+        return started_at.isValid();
+    }
+
+    qint64 get(Phase phase) const {
+        return phases[phase];
+    }
+
+    //! Returns the time between two phases, or -1 if one of them wasn't reached.
+    qint64 between(Phase from, Phase to) const;
+
+    //! Returns a human readable breakdown of the timings.
+    QString toString() const;
+
+    static QString phaseName(Phase phase);
+
+    //! Returns a stable identifier of `phase` for exported data.
+    //! The returned string has static storage duration.
+    static char const * phaseKey(Phase phase);
+};
+
+//! Keeps a rolling history of request timings per host.
+class RequestTimingLog
+{
+public:
+    //! Number of requests remembered per host
+    static constexpr int max_entries_per_host = 50;
+
+    struct Entry
+    {
+        QUrl url;
+        RequestTimings timings;
+    };
+
+public:
+    void add(QUrl const & url, RequestTimings const & timings);
+
+    QVector<Entry> forHost(QString const & host) const;
+
+    QStringList hosts() const;
+
+    void clear();
+
+    //! Writes all remembered timings as CSV into `device`.
+    bool exportCsv(QIODevice & device) const;
+
+private:
+    QHash<QString, QVector<Entry>> entries;
+};
+
+#endif // REQUESTTIMINGS_HPP
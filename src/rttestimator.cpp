@@ -0,0 +1,79 @@
+#include "rttestimator.hpp"
+
+#include <QtGlobal>
+#include <cmath>
+
+void RttEstimator::addSample(const QString &host, qint64 rtt)
+{
+    if(rtt < 0)
+        return;
+
+    auto it = this->estimates.find(host);
+    if(it == this->estimates.end())
+    {
+        // Forget everything instead of tracking usage, hosts will
+        // just start over with the configured network timeout.
+        if(this->estimates.size() >= max_hosts)
+            this->estimates.clear();
+
+        Estimate estimate;
+        estimate.srtt = rtt;
+        estimate.rttvar = rtt / 2.0;
+        this->estimates.insert(host, estimate);
+        return;
+    }
+
+    // RFC 6298, alpha = 1/8, beta = 1/4
+    it->rttvar = 0.75 * it->rttvar + 0.25 * std::abs(it->srtt - rtt);
+    it->srtt = 0.875 * it->srtt + 0.125 * rtt;
+}
+
+bool RttEstimator::hasEstimate(const QString &host) const
+{
+    return this->estimates.contains(host);
+}
+
+qint64 RttEstimator::smoothedRtt(const QString &host) const
+{
+    auto it = this->estimates.find(host);
+    if(it == this->estimates.end())
+        return -1;
+    return qint64(it->srtt);
+}
+
+qint64 RttEstimator::retransmissionTimeout(const QString &host) const
+{
+    auto it = this->estimates.find(host);
+    if(it == this->estimates.end())
+        return -1;
+    return qint64(it->srtt + 4.0 * it->rttvar);
+}
+
+qint64 RttEstimator::connectTimeout(const QString &host, qint64 fallback) const
+{
+    qint64 rto = this->retransmissionTimeout(host);
+    if(rto < 0)
+        return fallback;
+    // allow for a lost SYN and a slow resolver
+    return qBound(min_timeout, 3 * rto, qMax(min_timeout, fallback));
+}
+
+qint64 RttEstimator::handshakeTimeout(const QString &host, qint64 fallback) const
+{
+    qint64 rto = this->retransmissionTimeout(host);
+    if(rto < 0)
+        return fallback;
+    // TLS needs up to two round trips, plus the same slack as the connect
+    return qBound(min_timeout, 4 * rto, qMax(min_timeout, fallback));
+}
+
+qint64 RttEstimator::firstByteTimeout(const QString &host, qint64 fallback) const
+{
+    qint64 rto = this->retransmissionTimeout(host);
+    if(rto < 0)
+        return fallback;
+    // The server may need some time to think, so it gets a generous
+    // multiple of the round trip time, but never more than configured.
+    qint64 srtt = this->smoothedRtt(host);
+    return qBound(min_response_timeout, 8 * srtt + rto, qMax(min_response_timeout, fallback));
+}
@@ -0,0 +1,53 @@
+#ifndef RTTESTIMATOR_HPP
+#define RTTESTIMATOR_HPP
+
+#include <QHash>
+#include <QString>
+
+//! Keeps a smoothed round trip time estimate per host (RFC 6298) and
+//! derives the deadlines for the different phases of a request from it.
+//! Hosts we don't know anything about yet use the configured network timeout.
+class RttEstimator
+{
+public:
+    //! Lower bound for every adaptive deadline in milliseconds
+    static constexpr qint64 min_timeout = 1000;
+
+    //! Lower bound for the first byte deadline, servers may generate the response first
+    static constexpr qint64 min_response_timeout = 5000;
+
+    //! Maximum number of hosts we keep an estimate for
+    static constexpr int max_hosts = 1024;
+
+public:
+    //! Adds a measured round trip time in milliseconds for `host`.
+    void addSample(QString const & host, qint64 rtt);
+
+    bool hasEstimate(QString const & host) const;
+
+    //! Returns the smoothed round trip time for `host` or -1 if unknown.
+    qint64 smoothedRtt(QString const & host) const;
+
+    //! Returns the retransmission timeout (srtt + 4 * rttvar) for `host` or -1 if unknown.
+    qint64 retransmissionTimeout(QString const & host) const;
+
+    //! Deadline for resolving the host and establishing the connection.
+    qint64 connectTimeout(QString const & host, qint64 fallback) const;
+
+    //! Deadline for the TLS handshake after the connection was established.
+    qint64 handshakeTimeout(QString const & host, qint64 fallback) const;
+
+    //! Deadline for the server to send the first byte after the request was sent.
+    qint64 firstByteTimeout(QString const & host, qint64 fallback) const;
+
+private:
+    struct Estimate
+    {
+        double srtt = 0.0;
+        double rttvar = 0.0;
+    };
+
+    QHash<QString, Estimate> estimates;
+};
+
+#endif // RTTESTIMATOR_HPP
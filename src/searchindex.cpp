@@ -0,0 +1,591 @@
+#include "searchindex.hpp"
+
+#include <QTimer>
+#include <QSaveFile>
+#include <QFile>
+#include <QDataStream>
+#include <QRegularExpression>
+#include <QElapsedTimer>
+#include <QDateTime>
+#include <QSet>
+#include <QDebug>
+
+#include <algorithm>
+#include <cmath>
+
+//! Only the start of very large documents is indexed
+static const int MAX_INDEXED_SIZE = 256 * 1024;
+
+//! Changes are saved at most this often
+static const int SAVE_DELAY = 30000; // ms
+
+static const int MAX_SUMMARY_LENGTH = 200;
+
+static const quint32 INDEX_MAGIC = 0x4B534958; // "KSIX"
+static const quint32 INDEX_VERSION = 2;
+
+// BM25 parameters
+static const double BM25_K1 = 1.2;
+static const double BM25_B = 0.75;
+
+static bool isStopWord(QString const & word)
+{
+    static QSet<QString> const stop_words {
+        "an", "and", "are", "as", "at", "be", "by", "for", "from", "has", "in", "is", "it",
+        "of", "on", "or", "that", "the", "this", "to", "was", "were", "will", "with",
+    };
+    return stop_words.contains(word);
+}
+
+//! Splits `text` into lower case words and counts how often each occurs.
+static QHash<QString, int> tokenize(QString const & text, int & length)
+{
+    QHash<QString, int> terms;
+    length = 0;
+
+    int start = -1;
+    for(int i = 0; i <= text.size(); i++)
+    {
+        bool const is_word = (i < text.size()) and text.at(i).isLetterOrNumber();
+        if(is_word) {
+            if(start < 0)
+                start = i;
+            continue;
+        }
+        if(start < 0)
+            continue;
+
+        int const word_length = i - start;
+        if(word_length >= 2 and word_length <= 40)
+        {
+            QString word = text.mid(start, word_length).toLower();
+            if(not isStopWord(word)) {
+                terms[word] += 1;
+                length += 1;
+            }
+        }
+        start = -1;
+    }
+
+    return terms;
+}
+
+//! Removes markup that shouldn't be searchable, like link targets, and extracts a summary.
+static QString plainText(QByteArray const & body, QString const & format, QString & summary)
+{
+    QString text = QString::fromUtf8(body.left(MAX_INDEXED_SIZE));
+
+    if(format == "markdown" or format == "x-markdown") {
+        static QRegularExpression const link_target { "\\]\\([^)]*\\)" };
+        text.replace(link_target, "]");
+    }
+
+    QString result;
+    result.reserve(text.size());
+
+    bool const is_gemtext = (format == "gemini");
+    for(QString const & line : text.split('\n'))
+    {
+        QString content = line.trimmed();
+        if(is_gemtext and content.startsWith("```"))
+            continue;
+        if(is_gemtext and content.startsWith("=>")) {
+            // Only the label of a link is text, the url isn't
+            int url_start = 2;
+            while(url_start < content.size() and content.at(url_start).isSpace())
+                url_start += 1;
+            int label_start = url_start;
+            while(label_start < content.size() and not content.at(label_start).isSpace())
+                label_start += 1;
+            content = content.mid(label_start).trimmed();
+        }
+
+        bool const is_markup = content.startsWith('#') or content.startsWith('>') or content.startsWith('*');
+        if(summary.isEmpty() and not content.isEmpty() and not is_markup and not line.trimmed().startsWith("=>")) {
+            summary = content.left(MAX_SUMMARY_LENGTH);
+        }
+
+        result.append(content);
+        result.append('\n');
+    }
+    return result;
+}
+
+//! Postings are stored as variable length integers, the document ids delta encoded
+static void writeVarint(QByteArray & out, quint32 value)
+{
+    while(value >= 0x80) {
+        out.append(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+static bool readVarint(QByteArray const & in, int & pos, quint32 & value)
+{
+    value = 0;
+    for(int shift = 0; shift < 35; shift += 7)
+    {
+        if(pos >= in.size())
+            return false;
+        quint8 byte = quint8(in.at(pos++));
+        value |= quint32(byte & 0x7F) << shift;
+        if((byte & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+SearchIndex::SearchIndex(QObject *parent) : QObject(parent)
+{
+
+}
+
+SearchIndex::~SearchIndex()
+{
+    this->stop();
+}
+
+void SearchIndex::start(const QString &file_name)
+{
+    if(this->worker != nullptr)
+        return;
+
+    this->worker = new SearchIndexWorker(this);
+    this->worker->moveToThread(&this->thread);
+    connect(&this->thread, &QThread::finished, this->worker, &QObject::deleteLater);
+    connect(this, &SearchIndex::documentQueued, this->worker, &SearchIndexWorker::indexDocument);
+
+    this->thread.start(QThread::LowPriority);
+
+    QMetaObject::invokeMethod(this->worker, "load", Qt::QueuedConnection, Q_ARG(QString, file_name));
+}
+
+void SearchIndex::stop()
+{
+    if(this->worker == nullptr)
+        return;
+
+    QMetaObject::invokeMethod(this->worker, "save", Qt::BlockingQueuedConnection);
+
+    this->thread.quit();
+    this->thread.wait();
+    this->worker = nullptr;
+}
+
+void SearchIndex::setDocumentLimit(int limit)
+{
+    QMutexLocker lock { &this->mutex };
+    this->document_limit = std::max(0, limit);
+}
+
+bool SearchIndex::canIndex(const MimeType &mime)
+{
+    return mime.is("text", "gemini")
+        or mime.is("text", "plain")
+        or mime.is("text", "markdown")
+        or mime.is("text", "x-markdown");
+}
+
+void SearchIndex::addDocument(const QUrl &url, const QString &title, const QByteArray &body, const MimeType &mime)
+{
+    if(this->worker == nullptr or not canIndex(mime))
+        return;
+
+    // The body is implicitly shared, so queuing it doesn't copy it
+    emit this->documentQueued(url.toString(QUrl::FullyEncoded | QUrl::RemoveFragment), title, body, mime.subtype);
+}
+
+QVector<SearchIndex::Result> SearchIndex::search(const QString &query, int limit)
+{
+    int ignored;
+    QList<QString> terms = tokenize(query, ignored).keys();
+    if(terms.isEmpty())
+        return QVector<Result> { };
+
+    QMutexLocker lock { &this->mutex };
+
+    int const document_count = this->documents.size() - this->dead_documents;
+    if(document_count <= 0)
+        return QVector<Result> { };
+    double const average_length = std::max(1.0, double(this->total_length) / document_count);
+
+    struct Match {
+        int terms = 0;
+        double score = 0.0;
+    };
+    QHash<int, Match> matches;
+
+    for(auto const & term : terms)
+    {
+        auto it = this->postings.constFind(term);
+        if(it == this->postings.constEnd())
+            continue;
+
+        double const frequency = it->size();
+        double const idf = std::log(1.0 + (document_count - frequency + 0.5) / (frequency + 0.5));
+
+        for(auto const & posting : *it)
+        {
+            auto const & document = this->documents.at(posting.document);
+            if(not document.alive)
+                continue;
+
+            double const tf = posting.frequency;
+            double const norm = BM25_K1 * (1.0 - BM25_B + BM25_B * document.length / average_length);
+
+            auto & match = matches[posting.document];
+            match.terms += 1;
+            match.score += idf * (tf * (BM25_K1 + 1.0)) / (tf + norm);
+        }
+    }
+
+    QVector<int> ranked;
+    ranked.reserve(matches.size());
+    for(auto it = matches.begin(); it != matches.end(); ++it)
+        ranked.append(it.key());
+
+    // Documents containing all words are better than ones with a higher score
+    int const count = std::max(0, std::min(limit, ranked.size()));
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(), [&matches](int a, int b) {
+        Match const ma = matches.value(a);
+        Match const mb = matches.value(b);
+        if(ma.terms != mb.terms)
+            return ma.terms > mb.terms;
+        return ma.score > mb.score;
+    });
+
+    QVector<Result> results;
+    results.reserve(count);
+    for(int i = 0; i < count; i++)
+    {
+        auto const & document = this->documents.at(ranked.at(i));
+        results.append(Result {
+            document.url,
+            document.title,
+            document.summary,
+            matches.value(ranked.at(i)).score,
+        });
+    }
+    return results;
+}
+
+bool SearchIndex::isLoaded() const
+{
+    QMutexLocker lock { &this->mutex };
+    return this->loaded;
+}
+
+int SearchIndex::documentCount() const
+{
+    QMutexLocker lock { &this->mutex };
+    return this->documents.size() - this->dead_documents;
+}
+
+void SearchIndex::removeDocument(int id)
+{
+    auto & document = this->documents[id];
+    if(not document.alive)
+        return;
+
+    document.alive = false;
+    this->total_length -= document.length;
+    this->dead_documents += 1;
+
+    if(auto it = this->document_by_url.find(document.url); it != this->document_by_url.end() and *it == id)
+        this->document_by_url.erase(it);
+}
+
+SearchIndexWorker::SearchIndexWorker(SearchIndex *index) :
+    QObject(nullptr),
+    index(index)
+{
+
+}
+
+void SearchIndexWorker::load(const QString &file_name)
+{
+    this->file_name = file_name;
+
+    this->save_timer = new QTimer(this);
+    this->save_timer->setSingleShot(true);
+    this->save_timer->setInterval(SAVE_DELAY);
+    connect(this->save_timer, &QTimer::timeout, this, &SearchIndexWorker::save);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<SearchIndex::Document> documents;
+    QHash<QString, int> document_by_url;
+    QHash<QString, QVector<SearchIndex::Posting>> postings;
+    qint64 total_length = 0;
+
+    QFile file { file_name };
+    if(file.open(QFile::ReadOnly))
+    {
+        QByteArray data = qUncompress(file.readAll());
+        QDataStream stream { &data, QIODevice::ReadOnly };
+
+        // Version 1 didn't store when documents were indexed, they expire as if indexed now
+        qint64 const now = QDateTime::currentMSecsSinceEpoch();
+
+        quint32 magic, version;
+        stream >> magic >> version;
+        if(magic == INDEX_MAGIC and (version == 1 or version == INDEX_VERSION))
+        {
+            qint32 document_count;
+            stream >> document_count;
+            for(int i = 0; i < document_count and stream.status() == QDataStream::Ok; i++)
+            {
+                SearchIndex::Document document;
+                qint32 length;
+                stream >> document.url >> document.title >> document.summary >> length;
+                document.length = length;
+                document.indexed_at = now;
+                if(version >= 2)
+                    stream >> document.indexed_at;
+                total_length += length;
+                document_by_url.insert(document.url, documents.size());
+                documents.append(document);
+            }
+
+            qint32 term_count;
+            stream >> term_count;
+            for(int i = 0; i < term_count and stream.status() == QDataStream::Ok; i++)
+            {
+                QString term;
+                QByteArray encoded;
+                stream >> term >> encoded;
+
+                QVector<SearchIndex::Posting> list;
+                int pos = 0;
+                quint32 document = 0, delta, frequency;
+                while(readVarint(encoded, pos, delta) and readVarint(encoded, pos, frequency))
+                {
+                    document += delta;
+                    if(int(document) >= documents.size())
+                        break;
+                    list.append(SearchIndex::Posting { int(document), int(frequency) });
+                }
+                postings.insert(term, list);
+            }
+
+            if(stream.status() != QDataStream::Ok) {
+                qDebug() << "search index" << file_name << "is damaged, starting a new one";
+                documents.clear();
+                document_by_url.clear();
+                postings.clear();
+                total_length = 0;
+            }
+        }
+    }
+
+    QMutexLocker lock { &this->index->mutex };
+
+    // Documents indexed while loading are kept, they are newer
+    for(auto const & document : qAsConst(this->index->documents))
+    {
+        if(not document.alive)
+            continue;
+        if(auto it = document_by_url.find(document.url); it != document_by_url.end()) {
+            documents[*it].alive = false;
+            total_length -= documents[*it].length;
+        }
+    }
+    int const offset = documents.size();
+    for(auto const & document : qAsConst(this->index->documents))
+    {
+        if(document.alive)
+            document_by_url.insert(document.url, documents.size());
+        documents.append(document);
+    }
+    for(auto it = this->index->postings.cbegin(); it != this->index->postings.cend(); ++it)
+    {
+        auto & list = postings[it.key()];
+        for(auto const & posting : *it)
+            list.append(SearchIndex::Posting { posting.document + offset, posting.frequency });
+    }
+
+    this->index->documents = std::move(documents);
+    this->index->document_by_url = std::move(document_by_url);
+    this->index->postings = std::move(postings);
+    this->index->total_length = total_length + this->index->total_length;
+    this->index->dead_documents = 0;
+    for(auto const & document : qAsConst(this->index->documents))
+    {
+        if(not document.alive)
+            this->index->dead_documents += 1;
+    }
+    this->index->loaded = true;
+
+    lock.unlock();
+
+    this->evict();
+
+    qDebug() << "loaded search index with" << offset << "documents in" << timer.elapsed() << "ms";
+}
+
+void SearchIndexWorker::indexDocument(const QString &url, const QString &title, const QByteArray &body, const QString &format)
+{
+    // Tokenizing is the expensive part, so it's done without holding the lock
+    SearchIndex::Document document;
+    document.url = url;
+    document.title = title;
+    document.indexed_at = QDateTime::currentMSecsSinceEpoch();
+    QString text = plainText(body, format, document.summary);
+    auto terms = tokenize(title + "\n" + text, document.length);
+
+    {
+        QMutexLocker lock { &this->index->mutex };
+
+        if(auto it = this->index->document_by_url.find(url); it != this->index->document_by_url.end())
+        {
+            this->index->removeDocument(*it);
+        }
+
+        int const id = this->index->documents.size();
+        this->index->documents.append(document);
+        this->index->document_by_url.insert(url, id);
+        this->index->total_length += document.length;
+
+        for(auto it = terms.cbegin(); it != terms.cend(); ++it)
+        {
+            this->index->postings[it.key()].append(SearchIndex::Posting { id, it.value() });
+        }
+    }
+
+    this->evict();
+
+    this->dirty = true;
+    if(this->save_timer != nullptr and not this->save_timer->isActive())
+        this->save_timer->start();
+}
+
+void SearchIndexWorker::save()
+{
+    if(not this->dirty or this->file_name.isEmpty())
+        return;
+
+    this->evict();
+    this->compact();
+
+    // The containers are implicitly shared, so copying them keeps the lock short
+    QVector<SearchIndex::Document> documents;
+    QHash<QString, QVector<SearchIndex::Posting>> postings;
+    {
+        QMutexLocker lock { &this->index->mutex };
+        documents = this->index->documents;
+        postings = this->index->postings;
+    }
+
+    QByteArray data;
+    {
+        QDataStream stream { &data, QIODevice::WriteOnly };
+        stream << INDEX_MAGIC << INDEX_VERSION;
+
+        stream << qint32(documents.size());
+        for(auto const & document : documents)
+        {
+            stream << document.url << document.title << document.summary << qint32(document.length) << document.indexed_at;
+        }
+
+        stream << qint32(postings.size());
+        for(auto it = postings.cbegin(); it != postings.cend(); ++it)
+        {
+            QByteArray encoded;
+            int previous = 0;
+            for(auto const & posting : *it)
+            {
+                writeVarint(encoded, quint32(posting.document - previous));
+                writeVarint(encoded, quint32(posting.frequency));
+                previous = posting.document;
+            }
+            stream << it.key() << encoded;
+        }
+    }
+
+    QSaveFile file { this->file_name };
+    if(file.open(QFile::WriteOnly) and file.write(qCompress(data)) >= 0 and file.commit()) {
+        this->dirty = false;
+    } else {
+        qDebug() << "failed to save search index to" << this->file_name << file.errorString();
+    }
+}
+
+void SearchIndexWorker::evict()
+{
+    QMutexLocker lock { &this->index->mutex };
+
+    qint64 const oldest = QDateTime::currentMSecsSinceEpoch() - qint64(SearchIndex::max_age) * 24 * 60 * 60 * 1000;
+
+    // Documents are appended when they are indexed, so the
+    // least recently indexed ones come first
+    int const limit = this->index->document_limit;
+    int alive = this->index->documents.size() - this->index->dead_documents;
+    for(int i = 0; i < this->index->documents.size(); i++)
+    {
+        auto const & document = this->index->documents.at(i);
+        if(not document.alive)
+            continue;
+        if((limit <= 0 or alive <= limit) and document.indexed_at >= oldest)
+            break;
+
+        this->index->removeDocument(i);
+        alive -= 1;
+        this->dirty = true;
+    }
+
+    // Dead documents still occupy the postings in memory
+    if(this->index->dead_documents > this->index->documents.size() / 4) {
+        lock.unlock();
+        this->compact();
+    }
+}
+
+void SearchIndexWorker::compact()
+{
+    // The index is only changed on this thread, so it can be
+    // read without the lock while the new one is built
+    SearchIndex const & index = *this->index;
+    if(index.dead_documents == 0)
+        return;
+
+    // Replaced documents are dropped and the remaining ones renumbered
+    QVector<int> new_ids(index.documents.size(), -1);
+    QVector<SearchIndex::Document> documents;
+    QHash<QString, int> document_by_url;
+    documents.reserve(index.documents.size() - index.dead_documents);
+    for(int i = 0; i < index.documents.size(); i++)
+    {
+        auto const & document = index.documents.at(i);
+        if(not document.alive)
+            continue;
+        new_ids[i] = documents.size();
+        document_by_url.insert(document.url, documents.size());
+        documents.append(document);
+    }
+
+    QHash<QString, QVector<SearchIndex::Posting>> postings;
+    postings.reserve(index.postings.size());
+    for(auto it = index.postings.cbegin(); it != index.postings.cend(); ++it)
+    {
+        QVector<SearchIndex::Posting> list;
+        for(auto const & posting : *it)
+        {
+            if(int id = new_ids.at(posting.document); id >= 0)
+                list.append(SearchIndex::Posting { id, posting.frequency });
+        }
+        if(not list.isEmpty())
+            postings.insert(it.key(), list);
+    }
+
+    // Queries only wait for the swap
+    QMutexLocker lock { &this->index->mutex };
+    this->index->documents.swap(documents);
+    this->index->document_by_url.swap(document_by_url);
+    this->index->postings.swap(postings);
+    this->index->dead_documents = 0;
+    lock.unlock();
+
+    // The old containers are freed without holding the lock
+}
@@ -0,0 +1,137 @@
+#ifndef SEARCHINDEX_HPP
+#define SEARCHINDEX_HPP
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QVector>
+#include <QUrl>
+
+#include "mimeparser.hpp"
+
+class QTimer;
+class SearchIndexWorker;
+
+//! Full-text index over the text pages the user visited.
+//! Documents are tokenised and indexed on a background thread, the
+//! inverted index is kept in memory and saved compressed to disk.
+//! Queries are answered on the calling thread and ranked with BM25.
+//! The least recently indexed documents are dropped when the index
+//! exceeds its document limit, documents older than max_age expire.
+class SearchIndex : public QObject
+{
+    Q_OBJECT
+    friend class SearchIndexWorker;
+public:
+    struct Result
+    {
+        QString url;
+        QString title;
+        QString summary;
+        double score;
+    };
+
+    //! Number of days after which an indexed document is dropped
+    static constexpr int max_age = 90;
+
+public:
+    explicit SearchIndex(QObject *parent = nullptr);
+    ~SearchIndex() override;
+
+    //! Starts the indexing thread, which loads the index from `file_name`.
+    void start(QString const & file_name);
+
+    //! Saves the index and stops the indexing thread.
+    void stop();
+
+    //! Sets the maximum number of indexed documents, 0 for no limit.
+    void setDocumentLimit(int limit);
+
+    //! Returns true if documents of this type can be indexed.
+    static bool canIndex(MimeType const & mime);
+
+    //! Queues `body` for indexing and returns immediately. An already
+    //! indexed document with the same url is replaced.
+    void addDocument(QUrl const & url, QString const & title, QByteArray const & body, MimeType const & mime);
+
+    //! Returns the `limit` best documents matching `query`.
+    QVector<Result> search(QString const & query, int limit);
+
+    //! Returns false while the index is still loaded from disk.
+    bool isLoaded() const;
+
+    int documentCount() const;
+
+signals:
+    //! Hands a document to the indexing thread
+    void documentQueued(QString const & url, QString const & title, QByteArray const & body, QString const & format);
+
+private:
+    struct Document
+    {
+        QString url;
+        QString title;
+        QString summary;
+        int length = 0; // number of tokens
+        qint64 indexed_at = 0; // ms since epoch
+        bool alive = true;
+    };
+
+    struct Posting
+    {
+        int document;
+        int frequency;
+    };
+
+    //! Marks the document `id` as removed, its postings are dropped
+    //! when the index is compacted. The mutex must be locked.
+    void removeDocument(int id);
+
+private:
+    QThread thread;
+    SearchIndexWorker * worker = nullptr;
+
+    //! Guards all members below, they are written by the indexing thread
+    mutable QMutex mutex;
+
+    bool loaded = false;
+    int document_limit = 0;
+    QVector<Document> documents;
+    QHash<QString, int> document_by_url;
+    QHash<QString, QVector<Posting>> postings;
+    int dead_documents = 0;
+    qint64 total_length = 0;
+};
+
+//! Runs on the indexing thread of a SearchIndex
+class SearchIndexWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SearchIndexWorker(SearchIndex * index);
+
+public slots:
+    void load(QString const & file_name);
+
+    void indexDocument(QString const & url, QString const & title, QByteArray const & body, QString const & format);
+
+    void save();
+
+private:
+    //! Removes the least recently indexed documents while the index
+    //! is over its limits, and documents that are too old
+    void evict();
+
+    //! Removes the postings of replaced and evicted documents. Only this
+    //! thread changes the index, so the new index is built without the lock.
+    void compact();
+
+private:
+    SearchIndex * index;
+    QString file_name;
+    QTimer * save_timer = nullptr;
+    bool dirty = false;
+};
+
+#endif // SEARCHINDEX_HPP
@@ -0,0 +1,118 @@
+#include "singleinstance.hpp"
+
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QCryptographicHash>
+#include <QDebug>
+
+//! How long a second invocation waits for the running instance to accept the connection
+static const int CONNECT_TIMEOUT = 500; // ms
+
+//! How long a second invocation waits for the running instance to acknowledge the urls.
+//! The running instance may be busy, so this is more generous.
+static const int ACKNOWLEDGE_TIMEOUT = 5000; // ms
+
+SingleInstance::SingleInstance(const QString &key, QObject *parent) :
+    QObject(parent),
+    server(new QLocalServer(this))
+{
+    // The key usually is a path, which is neither a valid nor a short socket name
+    QByteArray hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Sha256).toHex();
+    this->server_name = "kristall-" + QString::fromUtf8(hash.left(16));
+
+    this->server->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(this->server, &QLocalServer::newConnection, this, &SingleInstance::on_newConnection);
+}
+
+SingleInstance::ForwardResult SingleInstance::forward(const QList<QUrl> &urls)
+{
+    QLocalSocket socket;
+    socket.connectToServer(this->server_name);
+    if(not socket.waitForConnected(CONNECT_TIMEOUT))
+    {
+        switch(socket.error())
+        {
+        case QLocalSocket::ServerNotFoundError:
+            return NotRunning;
+        case QLocalSocket::ConnectionRefusedError:
+            // The socket is left over from an instance that crashed
+            this->is_stale_socket = true;
+            return NotRunning;
+        default:
+            qDebug() << "failed to connect to the running instance:" << socket.errorString();
+            return NotResponding;
+        }
+    }
+
+    // One url per line, the message is terminated by an empty line so
+    // the receiver can tell a complete message from a broken connection
+    QByteArray message;
+    for(auto const & url : urls) {
+        message.append(url.toEncoded());
+        message.append('\n');
+    }
+    message.append('\n');
+
+    socket.write(message);
+    while(socket.bytesToWrite() > 0) {
+        if(not socket.waitForBytesWritten(ACKNOWLEDGE_TIMEOUT))
+            return NotResponding;
+    }
+
+    // The running instance acknowledges the message before we exit
+    if(not socket.waitForReadyRead(ACKNOWLEDGE_TIMEOUT))
+        return NotResponding;
+    if(not socket.readAll().startsWith("ok"))
+        return NotResponding;
+
+    socket.disconnectFromServer();
+    return Forwarded;
+}
+
+bool SingleInstance::listen()
+{
+    if(this->server->listen(this->server_name))
+        return true;
+
+    // Never take over the socket of an instance that is just busy
+    if(this->is_stale_socket and this->server->serverError() == QAbstractSocket::AddressInUseError) {
+        QLocalServer::removeServer(this->server_name);
+        if(this->server->listen(this->server_name))
+            return true;
+    }
+
+    qDebug() << "failed to listen for other instances:" << this->server->errorString();
+    return false;
+}
+
+void SingleInstance::on_newConnection()
+{
+    while(QLocalSocket * socket = this->server->nextPendingConnection())
+    {
+        connect(socket, &QLocalSocket::disconnected, socket, &QLocalSocket::deleteLater);
+        connect(socket, &QLocalSocket::readyRead, this, [this, socket]() {
+            // The message stays buffered in the socket until it is complete
+            QByteArray message = socket->peek(socket->bytesAvailable());
+            if(not message.startsWith('\n') and not message.contains("\n\n"))
+                return;
+            socket->readAll();
+
+            QList<QUrl> urls;
+            for(auto const & line : message.split('\n'))
+            {
+                if(line.isEmpty())
+                    break;
+                QUrl url = QUrl::fromEncoded(line);
+                if(url.isValid())
+                    urls.append(url);
+                else
+                    qDebug() << "received invalid url from other instance:" << line;
+            }
+
+            socket->write("ok\n");
+            socket->flush();
+
+            emit this->urlsReceived(urls);
+        });
+    }
+}
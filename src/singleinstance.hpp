@@ -0,0 +1,49 @@
+#ifndef SINGLEINSTANCE_HPP
+#define SINGLEINSTANCE_HPP
+
+#include <QObject>
+#include <QList>
+#include <QUrl>
+
+class QLocalServer;
+
+//! Makes sure only a single kristall process runs per configuration directory.
+//! A second invocation forwards its urls to the running instance via a local
+//! socket and exits, the running instance then opens them as new tabs.
+class SingleInstance : public QObject
+{
+    Q_OBJECT
+public:
+    enum ForwardResult {
+        Forwarded, //!< The running instance accepted the urls
+        NotRunning, //!< There is no running instance
+        NotResponding, //!< An instance is running, but didn't acknowledge the urls in time
+    };
+
+    //! `key` identifies the instance, processes with different keys don't see each other.
+    explicit SingleInstance(QString const & key, QObject *parent = nullptr);
+
+    //! Sends `urls` to the running instance.
+    ForwardResult forward(QList<QUrl> const & urls);
+
+    //! Starts accepting urls from other invocations. A leftover socket of a
+    //! crashed instance is only replaced if forward() found nobody listening on it.
+    bool listen();
+
+signals:
+    //! Another invocation wants to open `urls`. The list is empty
+    //! when it was started without urls.
+    void urlsReceived(QList<QUrl> const & urls);
+
+private slots:
+    void on_newConnection();
+
+private:
+    QString server_name;
+    QLocalServer * server;
+
+    //! forward() found the socket, but nobody accepted the connection
+    bool is_stale_socket = false;
+};
+
+#endif // SINGLEINSTANCE_HPP
@@ -1,15 +1,57 @@
 #include "ssltrust.hpp"
 
 #include <QDebug>
+#include <QFile>
+#include <QSaveFile>
 #include <cassert>
 
-void SslTrust::load(QSettings &settings)
+//! The journal is compacted when it contains this many records more than trusted hosts
+static const int JOURNAL_SLACK = 64;
+
+//! Journal records are single lines: host name, trust date, key type and key, separated by tabs
+static QByteArray encodeRecord(TrustedHost const & host)
+{
+    QByteArray record;
+    record.append(host.host_name.toUtf8());
+    record.append('\t');
+    record.append(host.trusted_at.toString(Qt::ISODateWithMs).toUtf8());
+    record.append('\t');
+    record.append(QByteArray::number(int(host.public_key.algorithm())));
+    record.append('\t');
+    record.append(host.public_key.toDer().toBase64());
+    record.append('\n');
+    return record;
+}
+
+static bool decodeRecord(QByteArray const & line, TrustedHost & host)
+{
+    auto fields = line.trimmed().split('\t');
+    if(fields.size() != 4)
+        return false;
+
+    bool ok;
+    auto key_type = QSsl::KeyAlgorithm(fields[2].toInt(&ok));
+    if(not ok)
+        return false;
+
+    host.host_name = QString::fromUtf8(fields[0]);
+    host.trusted_at = QDateTime::fromString(QString::fromUtf8(fields[1]), Qt::ISODateWithMs);
+    host.public_key = QSslKey(QByteArray::fromBase64(fields[3]), key_type, QSsl::Der, QSsl::PublicKey);
+    return not host.host_name.isEmpty() and not host.public_key.isNull();
+}
+
+void SslTrust::load(QSettings &settings, QString const & journal_file)
 {
     trust_level = TrustLevel(settings.value("trust_level", int(TrustOnFirstUse)).toInt());
     enable_ca = settings.value("enable_ca", QVariant::fromValue(false)).toBool();
 
     trusted_hosts.clear();
 
+    this->journal_file = journal_file;
+    this->journal_records = 0;
+    this->journal_failed = false;
+
+    // Hosts saved by older versions
     int size = settings.beginReadArray("trusted_hosts");
     for(int i = 0; i < size; i++)
     {
@@ -26,6 +68,32 @@ void SslTrust::load(QSettings &settings)
         trusted_hosts.insert(host);
     }
     settings.endArray();
+
+    QFile journal { journal_file };
+    if(journal.open(QFile::ReadOnly))
+    {
+        while(not journal.atEnd())
+        {
+            QByteArray line = journal.readLine();
+            this->journal_records += 1;
+
+            TrustedHost host;
+            if(decodeRecord(line, host)) {
+                trusted_hosts.insert(host);
+            } else {
+                // A crash while appending can leave a broken last line
+                qDebug() << "skipping invalid record in" << journal_file;
+            }
+        }
+    }
+
+    bool const migrate = (size > 0);
+    if(migrate or this->journal_records > trusted_hosts.rowCount() + JOURNAL_SLACK)
+    {
+        if(this->compact() and migrate) {
+            settings.remove("trusted_hosts");
+        }
+    }
 }
 
 void SslTrust::save(QSettings &settings) const
@@ -33,6 +101,10 @@ void SslTrust::save(QSettings &settings) const
     settings.setValue("trust_level", int(trust_level));
     settings.setValue("enable_ca", enable_ca);
 
+    // The trusted hosts are already saved in the journal
+    if(not this->journal_failed)
+        return;
+
     auto all = trusted_hosts.getAll();
     settings.beginWriteArray("trusted_hosts", all.size());
     for(int i = 0; i < all.size(); i++)
@@ -47,6 +119,59 @@ void SslTrust::save(QSettings &settings) const
     settings.endArray();
 }
 
+bool SslTrust::compact()
+{
+    if(this->journal_file.isEmpty())
+        return false;
+
+    // QSaveFile replaces the journal atomically, so a crash can't lose hosts
+    QSaveFile file { this->journal_file };
+    if(not file.open(QFile::WriteOnly)) {
+        qDebug() << "failed to compact" << this->journal_file << file.errorString();
+        this->journal_failed = true;
+        return false;
+    }
+
+    auto all = trusted_hosts.getAll();
+    for(auto const & host : all)
+    {
+        file.write(encodeRecord(host));
+    }
+
+    if(not file.commit()) {
+        qDebug() << "failed to compact" << this->journal_file << file.errorString();
+        this->journal_failed = true;
+        return false;
+    }
+
+    this->journal_records = all.size();
+    this->journal_failed = false;
+    return true;
+}
+
+bool SslTrust::insertHost(const TrustedHost &host)
+{
+    if(not trusted_hosts.insert(host))
+        return false;
+
+    if(this->journal_file.isEmpty() or this->journal_failed)
+        return true;
+
+    QFile journal { this->journal_file };
+    if(journal.open(QFile::WriteOnly | QFile::Append))
+    {
+        QByteArray record = encodeRecord(host);
+        if(journal.write(record) == record.size()) {
+            this->journal_records += 1;
+            return true;
+        }
+    }
+
+    qDebug() << "failed to append to" << this->journal_file << journal.errorString();
+    this->journal_failed = true;
+    return true;
+}
+
 bool SslTrust::addTrust(const QUrl &url, const QSslCertificate &certificate)
 {
     if(certificate.isNull())
@@ -62,7 +187,7 @@ bool SslTrust::addTrust(const QUrl &url, const QSslCertificate &certificate)
         host.trusted_at = QDateTime::currentDateTime();
         host.public_key = certificate.publicKey();
 
-        bool ok = trusted_hosts.insert(host);
+        bool ok = insertHost(host);
         assert(ok);
         return true;
     }
@@ -97,7 +222,7 @@ SslTrust::TrustStatus SslTrust::getTrust(const QUrl &url, const QSslCertificate
             host.trusted_at = QDateTime::currentDateTime();
             host.public_key = certificate.publicKey();
 
-            bool ok = trusted_hosts.insert(host);
+            bool ok = insertHost(host);
             assert(ok);
             return Trusted;
         }
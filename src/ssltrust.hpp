@@ -35,9 +35,16 @@ struct SslTrust
 
     bool enable_ca = false;
 
-    void load(QSettings & settings);
+    //! Loads the trust settings and the trusted hosts. The trusted hosts are
+    //! stored in the append-only `journal_file`, each trust decision is appended
+    //! right away. Hosts stored in `settings` by older versions are migrated.
+    void load(QSettings & settings, QString const & journal_file);
     void save(QSettings & settings) const;
 
+    //! Rewrites the journal so it contains only the current trusted hosts.
+    //! Must be called after hosts were removed. Returns `true` on success.
+    bool compact();
+
     //! Adds the certificate to the trust store. Returns `true` on success.
     bool addTrust(QUrl const & url, QSslCertificate const & certificate);
 
@@ -46,6 +53,18 @@ struct SslTrust
     TrustStatus getTrust(QUrl const & url, QSslCertificate const & certificate);
 
     static bool isTrustRelated(QSslError::SslError err);
+
+private:
+    //! Inserts the host and appends it to the journal
+    bool insertHost(TrustedHost const & host);
+
+    QString journal_file;
+
+    //! Number of records in the journal, used to decide when to compact it
+    int journal_records = 0;
+
+    //! When the journal can't be written, the hosts are saved in the settings like before
+    bool journal_failed = false;
 };
 
 #endif // SSLTRUST_HPP
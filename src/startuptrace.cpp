@@ -0,0 +1,43 @@
+#include "startuptrace.hpp"
+
+#include <QStringList>
+
+void StartupTrace::start()
+{
+    this->list.clear();
+    this->finished = false;
+    this->total_time = -1;
+    this->last_mark = 0;
+    this->timer.start();
+}
+
+void StartupTrace::mark(const QString &name)
+{
+    if(this->finished or not this->timer.isValid())
+        return;
+
+    qint64 const now = this->timer.elapsed();
+    this->list.append(Phase { name, now - this->last_mark });
+    this->last_mark = now;
+}
+
+void StartupTrace::finish()
+{
+    if(this->finished or not this->timer.isValid())
+        return;
+
+    this->mark("first paint");
+    this->total_time = this->timer.elapsed();
+    this->finished = true;
+}
+
+QString StartupTrace::toString() const
+{
+    QStringList lines;
+    for(auto const & phase : this->list)
+    {
+        lines << QString("%1: %2 ms").arg(phase.name).arg(phase.duration);
+    }
+    lines << QString("total: %1 ms").arg(this->total_time);
+    return lines.join("\n");
+}
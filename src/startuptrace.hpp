@@ -0,0 +1,51 @@
+#ifndef STARTUPTRACE_HPP
+#define STARTUPTRACE_HPP
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+//! Measures how long each phase of the application startup takes,
+//! from entering main() until the main window is painted the first time.
+class StartupTrace
+{
+public:
+    struct Phase
+    {
+        QString name;
+        qint64 duration; // in ms
+    };
+
+public:
+    void start();
+
+    //! Ends the current phase, which is named `name`.
+    void mark(QString const & name);
+
+    //! Ends the trace with the first paint of the main window.
+    void finish();
+
+    bool isFinished() const {
+        return this->finished;
+    }
+
+    QVector<Phase> phases() const {
+        return this->list;
+    }
+
+    //! Returns the time from start() to finish() in ms.
+    qint64 total() const {
+        return this->total_time;
+    }
+
+    QString toString() const;
+
+private:
+    QElapsedTimer timer;
+    qint64 last_mark = 0;
+    qint64 total_time = -1;
+    bool finished = false;
+    QVector<Phase> list;
+};
+
+#endif // STARTUPTRACE_HPP
@@ -35,6 +35,25 @@ void TabBrowsingHistory::replaceUrl(size_t const position, QUrl const & url)
     this->history.replace(position, url);
 }
 
+void TabBrowsingHistory::relocateUrl(const QUrl &old_url, const QUrl &new_url)
+{
+    for(int i = 0; i < this->history.size(); i++)
+    {
+        if(this->history.at(i).adjusted(QUrl::RemoveFragment) == old_url.adjusted(QUrl::RemoveFragment))
+        {
+            this->history.replace(i, new_url);
+            emit this->dataChanged(this->createIndex(i, 0), this->createIndex(i, 0));
+        }
+    }
+}
+
+void TabBrowsingHistory::setUrls(const QVector<QUrl> &urls)
+{
+    this->beginResetModel();
+    this->history = urls;
+    this->endResetModel();
+}
+
 QUrl TabBrowsingHistory::get(const QModelIndex &index) const
 {
     if(not index.isValid())
@@ -19,12 +19,22 @@ public:
     QModelIndex pushUrl(QModelIndex const & position, QUrl const & url);
     void replaceUrl(size_t const position, QUrl const & url);
 
+    //! Replaces all occurrences of `old_url` with `new_url`.
+    void relocateUrl(QUrl const & old_url, QUrl const & new_url);
+
     QUrl get(QModelIndex const & index) const;
 
     QModelIndex oneForward(const QModelIndex &index) const;
 
     QModelIndex oneBackward(const QModelIndex &index) const;
 
+    QVector<QUrl> urls() const {
+        return this->history;
+    }
+
+    //! Replaces the whole history, used when a session is restored.
+    void setUrls(QVector<QUrl> const & urls);
+
 public:
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
@@ -0,0 +1,111 @@
+#include "tracing.hpp"
+
+#include <QByteArray>
+
+//! Small thread ids are easier to read in the trace viewers than native handles
+static int currentThreadId()
+{
+    static std::atomic<int> next_id { 1 };
+    thread_local int const id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+TraceRecorder::TraceRecorder()
+{
+    this->timer.start();
+}
+
+void TraceRecorder::setEnabled(bool enabled)
+{
+    // Only the thread toggling recording allocates, writers never see the buffer before it exists
+    if(enabled and this->events == nullptr) {
+        this->events = std::make_unique<Event[]>(capacity);
+    }
+    this->enabled.store(enabled, std::memory_order_release);
+}
+
+void TraceRecorder::record(const char *name, const char *category, qint64 begin, qint64 end)
+{
+    this->append(name, category, begin, end - begin);
+}
+
+void TraceRecorder::mark(const char *name, const char *category)
+{
+    if(not this->isEnabled())
+        return;
+    this->append(name, category, this->now(), -1);
+}
+
+void TraceRecorder::append(const char *name, const char *category, qint64 begin, qint64 duration)
+{
+    if(not this->enabled.load(std::memory_order_acquire))
+        return;
+
+    quint64 const ticket = this->next.fetch_add(1, std::memory_order_relaxed);
+    Event & event = this->events[ticket % capacity];
+
+    // The sequence acts as a seqlock, so exportJson() skips events that are overwritten while it reads them
+    event.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    event.name = name;
+    event.category = category;
+    event.begin = begin;
+    event.duration = duration;
+    event.thread = currentThreadId();
+
+    event.sequence.store(ticket + 1, std::memory_order_release);
+}
+
+bool TraceRecorder::exportJson(QIODevice &device) const
+{
+    QByteArray json;
+    json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    bool first = true;
+    if(this->events != nullptr)
+    {
+        quint64 const end = this->next.load(std::memory_order_acquire);
+        quint64 const begin = (end > quint64(capacity)) ? (end - capacity) : 0;
+        for(quint64 ticket = begin; ticket < end; ticket++)
+        {
+            Event const & event = this->events[ticket % capacity];
+
+            quint64 const sequence = event.sequence.load(std::memory_order_acquire);
+            char const * name = event.name;
+            char const * category = event.category;
+            qint64 const start = event.begin;
+            qint64 const duration = event.duration;
+            int const thread = event.thread;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if(sequence != ticket + 1 or event.sequence.load(std::memory_order_relaxed) != sequence)
+                continue;
+
+            if(not first)
+                json.append(",\n");
+            first = false;
+
+            // Names and categories are literals from the source, so they need no escaping
+            json.append("{\"name\":\"");
+            json.append(name);
+            json.append("\",\"cat\":\"");
+            json.append(category);
+            if(duration < 0) {
+                json.append("\",\"ph\":\"i\",\"s\":\"t\"");
+            } else {
+                json.append("\",\"ph\":\"X\",\"dur\":");
+                json.append(QByteArray::number(double(duration) / 1000.0, 'f', 3));
+            }
+            json.append(",\"ts\":");
+            json.append(QByteArray::number(double(start) / 1000.0, 'f', 3));
+            json.append(",\"pid\":1,\"tid\":");
+            json.append(QByteArray::number(thread));
+            json.append("}");
+        }
+    }
+
+    json.append("\n]}\n");
+
+    return (device.write(json) == json.size());
+}
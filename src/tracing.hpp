@@ -0,0 +1,116 @@
+#ifndef TRACING_HPP
+#define TRACING_HPP
+
+#include <QElapsedTimer>
+#include <QIODevice>
+
+#include <atomic>
+#include <memory>
+
+//! Records timed spans into a fixed size ring buffer, which can be exported
+//! as Chrome trace event JSON for chrome://tracing or Perfetto.
+//! Recording is lock-free, spans can be recorded from any thread.
+//!
+//! The KRISTALL_TRACE macros are only compiled in when KRISTALL_TRACING
+//! is defined, which is done by building with `qmake CONFIG+=tracing`.
+class TraceRecorder
+{
+public:
+    //! Number of events kept, older events are overwritten
+    static constexpr int capacity = 1 << 16;
+
+public:
+    TraceRecorder();
+
+    //! Starts or stops recording. The buffer is allocated when
+    //! recording is started the first time.
+    void setEnabled(bool enabled);
+
+    bool isEnabled() const {
+        return this->enabled.load(std::memory_order_relaxed);
+    }
+
+    //! Returns the time since the recorder was created in ns.
+    qint64 now() const {
+        return this->timer.nsecsElapsed();
+    }
+
+    //! Records a span from `begin` to `end`. `name` and `category`
+    //! must be string literals, only the pointers are stored.
+    void record(char const * name, char const * category, qint64 begin, qint64 end);
+
+    //! Records an instant event.
+    void mark(char const * name, char const * category);
+
+    //! Writes all recorded events as Chrome trace event JSON.
+    bool exportJson(QIODevice & device) const;
+
+    //! Returns the number of events recorded, including overwritten ones.
+    quint64 recordedCount() const {
+        return this->next.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Event
+    {
+        //! 0 while the event is written, otherwise its ticket + 1
+        std::atomic<quint64> sequence { 0 };
+        char const * name = nullptr;
+        char const * category = nullptr;
+        qint64 begin = 0;
+        qint64 duration = 0; // -1 for instant events
+        int thread = 0;
+    };
+
+    void append(char const * name, char const * category, qint64 begin, qint64 duration);
+
+private:
+    QElapsedTimer timer;
+    std::atomic<bool> enabled { false };
+    std::atomic<quint64> next { 0 };
+    std::unique_ptr<Event[]> events;
+};
+
+//! Records a span from its construction to its destruction
+class TraceScope
+{
+public:
+    TraceScope(TraceRecorder & recorder, char const * name, char const * category) :
+        recorder(recorder.isEnabled() ? &recorder : nullptr),
+        name(name),
+        category(category),
+        begin((this->recorder != nullptr) ? recorder.now() : 0)
+    {
+    }
+
+    TraceScope(TraceScope const &) = delete;
+    TraceScope & operator=(TraceScope const &) = delete;
+
+    ~TraceScope()
+    {
+        if(this->recorder != nullptr)
+            this->recorder->record(this->name, this->category, this->begin, this->recorder->now());
+    }
+
+private:
+    TraceRecorder * recorder;
+    char const * name;
+    char const * category;
+    qint64 begin;
+};
+
+#ifdef KRISTALL_TRACING
+#define KRISTALL_TRACE_CONCAT_(a, b) a##b
+#define KRISTALL_TRACE_CONCAT(a, b) KRISTALL_TRACE_CONCAT_(a, b)
+
+//! Traces the enclosing scope
+#define KRISTALL_TRACE(name, category) TraceScope KRISTALL_TRACE_CONCAT(kristall_trace_, __LINE__) { kristall::tracer, name, category }
+
+//! Records an instant event
+#define KRISTALL_TRACE_MARK(name, category) kristall::tracer.mark(name, category)
+#else
+#define KRISTALL_TRACE(name, category) do { } while(false)
+#define KRISTALL_TRACE_MARK(name, category) do { } while(false)
+#endif
+
+#endif // TRACING_HPP
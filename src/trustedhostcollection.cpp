@@ -8,14 +8,16 @@ TrustedHostCollection::TrustedHostCollection(QObject *parent)
 }
 
 TrustedHostCollection::TrustedHostCollection(const TrustedHostCollection & other) :
-    items(other.items)
+    items(other.items),
+    index_by_host(other.index_by_host)
 {
     assert(other.parent() == nullptr);
 
 }
 
 TrustedHostCollection::TrustedHostCollection(TrustedHostCollection &&other) :
-    items(std::move(other.items))
+    items(std::move(other.items)),
+    index_by_host(std::move(other.index_by_host))
 {
     assert(other.parent() == nullptr);
 }
@@ -83,6 +85,7 @@ TrustedHostCollection &TrustedHostCollection::operator=(const TrustedHostCollect
 {
     beginResetModel();
     this->items = other.items;
+    this->index_by_host = other.index_by_host;
     endResetModel();
     return *this;
 }
@@ -91,6 +94,7 @@ TrustedHostCollection &TrustedHostCollection::operator=(TrustedHostCollection &&
 {
     beginResetModel();
     this->items = std::move(other.items);
+    this->index_by_host = std::move(other.index_by_host);
     endResetModel();
     return *this;
 }
@@ -99,18 +103,17 @@ void TrustedHostCollection::clear()
 {
     beginResetModel();
     this->items.clear();
+    this->index_by_host.clear();
     endResetModel();
 }
 
 bool TrustedHostCollection::insert(const TrustedHost &host)
 {
-    for(auto const & item : qAsConst(items))
-    {
-        if(item.host_name == host.host_name)
-            return false;
-    }
+    if(index_by_host.contains(host.host_name))
+        return false;
 
     beginInsertRows(QModelIndex { }, items.size(), items.size() + 1);
+    index_by_host.insert(host.host_name, items.size());
     items.append(host);
     endInsertRows();
 
@@ -119,12 +122,10 @@ bool TrustedHostCollection::insert(const TrustedHost &host)
 
 std::optional<TrustedHost> TrustedHostCollection::get(QString const & host_name) const
 {
-    for(auto const & item : items)
-    {
-        if(item.host_name == host_name)
-            return item;
-    }
-    return std::nullopt;
+    auto it = index_by_host.constFind(host_name);
+    if(it == index_by_host.constEnd())
+        return std::nullopt;
+    return items.at(*it);
 }
 
 std::optional<TrustedHost> TrustedHostCollection::get(const QModelIndex &index) const
@@ -144,6 +145,8 @@ void TrustedHostCollection::remove(const QModelIndex &index)
         return;
     beginRemoveRows(QModelIndex{}, index.row(), index.row());
     items.removeAt(index.row());
+    // All following rows moved up by one
+    reindex();
     endRemoveRows();
 }
 
@@ -151,3 +154,13 @@ QVector<TrustedHost> TrustedHostCollection::getAll() const
 {
     return items;
 }
+
+void TrustedHostCollection::reindex()
+{
+    index_by_host.clear();
+    index_by_host.reserve(items.size());
+    for(int i = 0; i < items.size(); i++)
+    {
+        index_by_host.insert(items.at(i).host_name, i);
+    }
+}
@@ -2,6 +2,7 @@
 #define TRUSTEDHOSTCOLLECTION_HPP
 
 #include <QAbstractTableModel>
+#include <QHash>
 
 #include "trustedhost.hpp"
 #include <optional>
@@ -41,8 +42,14 @@ public:
 
     QVector<TrustedHost> getAll() const;
 
+private:
+    void reindex();
+
 private:
     QVector<TrustedHost> items;
+
+    //! Maps host names to their row in `items`
+    QHash<QString, int> index_by_host;
 };
 
 #endif // TRUSTEDHOSTCOLLECTION_HPP
@@ -57,6 +57,20 @@ void MediaPlayer::stopPlaying()
     this->player.stop();
 }
 
+bool MediaPlayer::isPlaying() const
+{
+    return (this->player.state() == QMediaPlayer::PlayingState);
+}
+
+void MediaPlayer::clearMedia()
+{
+    this->player.stop();
+    this->player.setMedia(QMediaContent { });
+
+    this->media_stream.close();
+    this->media_stream.setData(QByteArray { });
+}
+
 void MediaPlayer::on_playpause_button_clicked()
 {
     if(this->player.state() != QMediaPlayer::PlayingState) {
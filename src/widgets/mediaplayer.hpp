@@ -22,6 +22,11 @@ public:
 
     void stopPlaying();
 
+    bool isPlaying() const;
+
+    //! Stops playback and releases the media data.
+    void clearMedia();
+
 private slots:
     void on_playpause_button_clicked();
 
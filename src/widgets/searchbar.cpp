@@ -3,14 +3,64 @@
 
 #include <QKeyEvent>
 #include <QCompleter>
+#include <QSet>
+
+//! Maximum number of entries shown by the completer
+static const int MAX_COMPLETIONS = 12;
+
+//! The url that is inserted when a completion is selected
+static const int UrlRole = Qt::UserRole + 1;
 
 SearchBar::SearchBar(QWidget *parent) : QLineEdit(parent)
 {
+    // The completions are already filtered and ranked, so
+    // the completer must show them as they are.
     QCompleter *completer = new QCompleter(this);
-    completer->setModel(&kristall::favourites);
-    completer->setCaseSensitivity(Qt::CaseInsensitive);
-    completer->setCompletionRole(Qt::DisplayRole);
+    completer->setModel(&this->completions);
+    completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    completer->setCompletionRole(UrlRole);
+    completer->setMaxVisibleItems(MAX_COMPLETIONS);
     this->setCompleter(completer);
+
+    // QLineEdit updates the completer after emitting textEdited
+    connect(this, &QLineEdit::textEdited, this, &SearchBar::updateCompletions);
+}
+
+void SearchBar::updateCompletions(const QString &text)
+{
+    this->completions.clear();
+
+    QString const needle = text.trimmed();
+    if(needle.isEmpty())
+        return;
+
+    QSet<QString> seen;
+    auto add = [&](QString const & url, QString const & title) {
+        if(seen.contains(url))
+            return;
+        seen.insert(url);
+
+        auto item = new QStandardItem(title.isEmpty() ? url : QString("%1 - %2").arg(url, title));
+        item->setData(url, UrlRole);
+        this->completions.appendRow(item);
+    };
+
+    // Favourites were chosen by the user, so they are listed first
+    for(auto const & fav : kristall::favourites.allFavourites())
+    {
+        if(this->completions.rowCount() >= MAX_COMPLETIONS / 2)
+            break;
+        QString url = fav.second->destination.toString(QUrl::FullyEncoded);
+        if(url.contains(needle, Qt::CaseInsensitive) or fav.second->title.contains(needle, Qt::CaseInsensitive))
+            add(url, fav.second->title);
+    }
+
+    for(auto const & entry : kristall::global_history.complete(needle, MAX_COMPLETIONS))
+    {
+        if(this->completions.rowCount() >= MAX_COMPLETIONS)
+            break;
+        add(entry.url, entry.title);
+    }
 }
 
 void SearchBar::keyPressEvent(QKeyEvent *event)
@@ -2,6 +2,7 @@
 #define SEARCHBAR_HPP
 
 #include <QLineEdit>
+#include <QStandardItemModel>
 
 class SearchBar : public QLineEdit
 {
@@ -19,8 +20,14 @@ public:
     void focusInEvent(QFocusEvent *event) override;
     void focusOutEvent(QFocusEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
+private slots:
+    void updateCompletions(QString const & text);
+
 private:
     bool selectall_flag;
+
+    //! Favourites and history entries matching the current text
+    QStandardItemModel completions;
 };
 
 #endif // SEARCHBAR_HPP